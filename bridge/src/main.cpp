@@ -4,13 +4,37 @@
 #define   MESH_PREFIX     "CloudLED"
 #define   MESH_PASSWORD   "somethingSneaky!"
 
+//// Mesh events capture (serial: "D" dumps, see cloud/capture)
+// #define MESH_CAPTURE
+////
+
+#ifdef MESH_CAPTURE
+  #include "capture.h"      // cloud/src
+  CaptureRing capture;
+#endif
+
+#include "transport.h"      // cloud/src: show commands are sent as critical (acked, resent)
+
 
 // prototypes
+void meshBroadcast( String &msg, bool includeSelf );
+void meshSingle( uint32_t to, String &msg );
 void receivedCallback( uint32_t from, String &msg );
+void handleMessage( uint32_t from, String &msg );
 void changedConnectionCallback();
+void nodeTimeAdjustedCallback(int32_t offset);
 
 painlessMesh  mesh;
 
+// Firmware share (cloud/src/firmware.h): FH=0 tells the clouds not to wait for me to boot a new image
+#define FW_SILENT_MS    60000
+uint32_t silentAt = 0;
+
+// Last timeline sent (TL= chunks), resent to the nodes that miss some (TN=)
+#define TIMELINE_CHUNKS 32
+String timelineChunks[TIMELINE_CHUNKS];
+uint32_t timelineChecksum = 0;
+
 void setup() {
   Serial.begin(115200);
   
@@ -21,18 +45,152 @@ void setup() {
 
   mesh.onReceive(&receivedCallback);
   mesh.onChangedConnections(&changedConnectionCallback);
+  mesh.onNodeTimeAdjusted(&nodeTimeAdjustedCallback);
+
+  #ifdef MESH_CAPTURE
+    capture.clock = []() { return (uint32_t)(mesh.getNodeTime()/1000); };
+  #endif
+
+  transport.broadcast = meshBroadcast;
+  transport.single = meshSingle;
+  transport.handler = handleMessage;
+  transport.begin(mesh.getNodeId());
   Serial.println("Setup done ;)");
 }
 
+// TL=<chunk>/<chunks>,<cues>,<checksum>:... (cloud/src/timeline.h)
+void keepChunk(String& msg) 
+{
+  int slash = msg.indexOf("/");
+  int comma = msg.indexOf(",");
+  int comma2 = msg.indexOf(",", comma+1);
+  int colon = msg.indexOf(":");
+  if (slash < 0 || comma < 0 || comma2 < 0 || colon < 0) return;
+
+  int index = msg.substring(3, slash).toInt();
+  uint32_t checksum = strtoul(msg.substring(comma2+1, colon).c_str(), NULL, 16);
+  if (index < 0 || index >= TIMELINE_CHUNKS) return;
+  if (checksum != timelineChecksum) {
+    for (int k=0; k<TIMELINE_CHUNKS; k++) timelineChunks[k] = "";
+    timelineChecksum = checksum;
+  }
+  timelineChunks[index] = msg;
+}
+
+// TN=<checksum>,<missing chunks mask>: node got TP= before the whole timeline
+void resendChunks(uint32_t from, String& msg) 
+{
+  int comma = msg.indexOf(",");
+  if (comma < 0) return;
+  uint32_t checksum = strtoul(msg.substring(3, comma).c_str(), NULL, 16);     // 0: no chunk received
+  uint32_t missing = strtoul(msg.substring(comma+1).c_str(), NULL, 16);
+  std::list<uint32_t> node = { from };
+
+  int resent = 0;
+  for (int k=0; k<TIMELINE_CHUNKS; k++)
+    if ((missing & (1UL << k)) && timelineChunks[k].length() > 0 && (!checksum || checksum == timelineChecksum)) {
+      transport.sendCritical(timelineChunks[k], node);
+      resent++;
+    }
+  Serial.printf("bridge:  Timeline not ready on %u, missing %08x, %d chunks resent\n", from, missing, resent);
+}
+
+// Serial commands (show timeline, see cloud/show):
+//   MESH <msg>               broadcast msg
+//   PLAY <delay> [<seek>]    start timeline in delay ms, at seek ms of the show
+//   STOP                     stop timeline
+//   STATS                    delivery of the critical commands
+void serialCommand(String line) 
+{
+  uint32_t now = mesh.getNodeTime()/1000;
+
+  if (line.startsWith("MESH ")) {
+    String msg = line.substring(5);
+    if (msg.startsWith("TL=")) keepChunk(msg);
+    transport.sendCritical(msg, mesh.getNodeList());
+  }
+  else if (line.startsWith("PLAY")) {
+    line = line.substring(4);
+    line.trim();
+    int pos = line.indexOf(" ");
+    uint32_t delay = strtoul(line.c_str(), NULL, 10);
+    uint32_t seek = (pos == -1) ? 0 : strtoul(line.substring(pos+1).c_str(), NULL, 10);
+    transport.sendCritical("TP=" + String(now + delay - seek), mesh.getNodeList());
+    Serial.printf("bridge:  Play at %u (seek %u)\n", now + delay, seek);
+  }
+  else if (line == "STOP") {
+    transport.sendCritical("TS", mesh.getNodeList());
+  }
+  else if (line == "STATS") {
+    transport.log();
+  }
+  #ifdef MESH_CAPTURE
+    else if (line == "D") capture.dump();
+  #endif
+}
+
 void loop() {
   mesh.update();
+  transport.update();
+
+  if (!silentAt || millis() - silentAt >= FW_SILENT_MS) {
+    silentAt = max((uint32_t)1, millis());
+    transport.sendAll("FH=0");
+  }
+
+  if (Serial.available()) {
+    String line = Serial.readStringUntil('\n');
+    line.trim();
+    serialCommand(line);
+  }
+}
+
+// Mesh transport: what the bridge sends (MESH, PLAY, STOP, resends, acks, FH=0) is captured too
+void meshBroadcast( String &msg, bool includeSelf ) {
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_SEND, 0, msg);
+  #endif
+  mesh.sendBroadcast(msg, includeSelf);
+}
+
+void meshSingle( uint32_t to, String &msg ) {
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_SEND, to, msg);
+  #endif
+  mesh.sendSingle(to, msg);
 }
 
 void receivedCallback( uint32_t from, String &msg ) {
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_RECV, from, msg);
+  #endif
+  transport.receive(from, msg);
+}
+
+void handleMessage( uint32_t from, String &msg ) {
   Serial.printf("bridge:  Received from %u msg=%s\n", from, msg.c_str());
+  if (msg.startsWith("TN=")) resendChunks(from, msg);
 }
 
 void changedConnectionCallback() 
 {
   Serial.printf("bridge:  Changed connections, node count = %d \n", mesh.getNodeList().size());
+  #ifdef MESH_CAPTURE
+    std::list<uint32_t> nodes = mesh.getNodeList();
+    uint8_t ids[4*64];
+    int n = 0;
+    for (uint32_t id : nodes) {
+      if (n == 64) break;
+      for (int k=0; k<4; k++) ids[4*n+k] = id >> (8*k);
+      n++;
+    }
+    capture.record(CAPTURE_TOPOLOGY, 0, nodes.size(), ids, 4*n);
+  #endif
+}
+
+void nodeTimeAdjustedCallback(int32_t offset) 
+{
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_TIME, 0, offset, nullptr, 0);
+  #endif
 }
\ No newline at end of file
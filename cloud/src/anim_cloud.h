@@ -0,0 +1,95 @@
+#ifndef anim_cloud_h
+#define anim_cloud_h
+
+#include <K32_light.h>
+#include "output.h"
+#include "outputs.h"
+
+// CLOUD ANIM
+//   base of the macro anims: prepare() replaces init() so that the random state 
+//   of the next macro (colors...) can be picked ahead of time with arm().
+//   play() will then reuse the armed state instead of initializing again.
+//
+//   render() draws one frame into a scratch buffer instead of the strip,
+//   pixel() / all() / clear() / size() follow the current target,
+//   on strip colors go through the output stage (master, gamma), then the outputs map if any.
+//
+//   globalOffset / globalSize place the strip in the virtual strip of all clouds:
+//   pixel i is at globalOffset + i, anims drawing in global coordinates flow from cloud to cloud.
+//
+class Anim_cloud : public K32_anim {
+  public:
+    bool armed = false;
+    bool kept = false;
+    bool retargeted = true;     // drawing target changed: stateful anims must redraw everything
+
+    CRGBW* canvas = nullptr;
+    CRGBW* lastCanvas = nullptr;
+    int canvasSize = 0;
+
+    // Slice of the virtual strip of all clouds drawn by this node (globalSize 0 = not known yet)
+    int globalOffset = 0;
+    int globalSize = 0;
+
+    virtual void prepare() {}
+
+    // Pick next state now, consumed by the next play()
+    void arm() {
+      this->prepare();
+      this->armed = true;
+    }
+
+    // Keep current state and last frame: the strip already shows it (end of fade),
+    // the next play() goes on drawing from there without a redraw
+    void takeOver() {
+      this->armed = true;
+      this->kept = true;
+    }
+
+    void init() {
+      if (!this->armed) this->prepare();
+      if (!this->kept) this->retargeted = true;
+      this->armed = false;
+      this->kept = false;
+      this->lastCanvas = nullptr;
+    }
+
+    // Draw frame into buf[size]
+    void render(int frame[ANIM_DATA_SLOTS], CRGBW* buf, int size) {
+      if (buf != this->lastCanvas) this->retargeted = true;
+      this->canvas = buf;
+      this->canvasSize = size;
+      this->draw(frame);
+      this->lastCanvas = buf;
+      this->canvas = nullptr;
+    }
+
+    // Virtual strip size, own strip if unknown
+    int fullSize() {
+      return max(this->globalSize, this->globalOffset + this->size());
+    }
+
+    int size() {
+      if (this->canvas) return this->canvasSize;
+      return K32_anim::size();
+    }
+
+    void clear() {
+      if (this->canvas || outputs) this->all(CRGBW{0,0,0});
+      else K32_anim::clear();
+    }
+
+    void all(CRGBW color) {
+      if (this->canvas) for (int i=0; i<this->canvasSize; i++) this->canvas[i] = color;
+      else if (outputs) outputs->all(output.apply(color));
+      else K32_anim::all(output.apply(color));
+    }
+
+    void pixel(int i, CRGBW color) {
+      if (this->canvas) this->canvas[i] = color;
+      else if (outputs) outputs->pix(i, output.apply(color));
+      else K32_anim::pixel(i, output.apply(color));
+    }
+};
+
+#endif
@@ -1,4 +1,9 @@
 #include <K32_light.h>
+#include "anim_cloud.h"
+#include "compositor.h"
+#include "noise.h"
+#include "spatial.h"
+#include "probe.h"
 
 #define N_COLOR 8
 
@@ -15,13 +20,18 @@ CRGBW colorPreset[N_COLOR] = {
 };
 
 // WIND
+//   smooth noise field drifting along the cloud: pixel x = position * size + i,
+//   y = show time, identical on every node.
 //
-class Anim_cloud_wind : public K32_anim {
-  public:
-    int lastTime = 0;
-    int nextTime = 0;
+#define WIND_PIXEL    32      // 1/256 cell per pixel: 8 pixels per noise cell
+#define WIND_SHIFT_Y  1       // time >> 1: 512 ms per noise cell
+#define WIND_SHIFT_X  3       // time >> 3: drift of one cell per 2 s
+
+Probe windProbe("wind");
 
-    void init() {}
+class Anim_cloud_wind : public Anim_cloud {
+  public:
+    void prepare() {}
     void draw (int data[ANIM_DATA_SLOTS])
     { 
       int duration = data[0];
@@ -30,33 +40,32 @@ class Anim_cloud_wind : public K32_anim {
       int turn    = data[3];
       int position = data[4];
       int count = data[5];
-      
-      float progress = time*1.0f/duration;
 
-      if (time < lastTime) nextTime = 0;
-      lastTime = time;
+      windProbe.begin();
 
-      if (time > nextTime) 
-      {
-        for (int i=0; i<this->size(); i++) {
-          byte rand = random(150, 250);
-          CRGBW color = (count > 1) ? CRGBW{0,rand,rand-50} : CRGBW{rand/3,rand,0};
-          this->pixel(i, color);
-        }
-        nextTime = time + random(30, 140);
+      uint32_t showTime = ((uint32_t)round * count + turn) * duration + time;
+      uint32_t y = showTime >> WIND_SHIFT_Y;
+      uint32_t x = (uint32_t)position * this->size() * WIND_PIXEL + (showTime >> WIND_SHIFT_X);
+
+      for (int i=0; i<this->size(); i++, x += WIND_PIXEL) {
+        byte level = 150 + (noise.fractal(x, y) * 100 >> 8);
+        CRGBW color = (count > 1) ? CRGBW{0,level,level-50} : CRGBW{level/3,level,0};
+        this->pixel(i, color);
       }
+
+      windProbe.end();
     }
 };
 
 
 // BREATH
 //
-class Anim_cloud_breath : public K32_anim {
+class Anim_cloud_breath : public Anim_cloud_layers {
   public:
     CRGBW background;
 
-    void init() { this->background = colorPreset[random(0,N_COLOR)]; }
-    void draw (int data[ANIM_DATA_SLOTS])
+    void prepare() { this->background = colorPreset[random(0,N_COLOR)]; }
+    void compose (int data[ANIM_DATA_SLOTS])
     { 
       int duration = data[0];
       int time    = data[1];
@@ -68,19 +77,19 @@ class Anim_cloud_breath : public K32_anim {
       float progress = time*1.0f/duration;
       byte breath = 70 + (0.5f + 0.5f * sin(2 * PI * progress)) * 185;
 
-      this->all( (CRGBW)(background%breath) );
+      this->solid(background, BLEND_ADD, breath);
     }
 };
 
 
 // SPARKLE
 //
-class Anim_cloud_sparkle : public K32_anim {
+class Anim_cloud_sparkle : public Anim_cloud {
   public:
     int lastTime = 0;
     int nextTime = 0;
 
-    void init() {}
+    void prepare() {}
     void draw (int data[ANIM_DATA_SLOTS])
     { 
       int duration = data[0];
@@ -93,7 +102,9 @@ class Anim_cloud_sparkle : public K32_anim {
       float progress = time*1.0f/duration;
 
       if (time < lastTime) nextTime = 0;
+      if (this->retargeted) nextTime = -1;      // new target (fade buffer): redraw on this frame
       lastTime = time;
+      this->retargeted = false;
 
       if (time > nextTime) 
       {
@@ -112,15 +123,15 @@ class Anim_cloud_sparkle : public K32_anim {
 
 // CRAWLER
 //
-class Anim_cloud_crawler : public K32_anim {
+class Anim_cloud_crawler : public Anim_cloud_layers {
   public:
     CRGBW background;
     
-    void init() {
+    void prepare() {
       this->background = colorPreset[random(0,N_COLOR)];
     }
 
-    void draw (int data[ANIM_DATA_SLOTS])
+    void compose (int data[ANIM_DATA_SLOTS])
     { 
       int duration  = data[0];
       int time      = data[1];
@@ -131,24 +142,22 @@ class Anim_cloud_crawler : public K32_anim {
       
       float progress = time*1.0f/duration;
       
-      this->clear();
-      
       if (turn == position) 
       {
 
         int crawlerSize = 10;
-
-        // CRAWLER
         int pos = (int)(progress * this->size());
-        for (int i=pos; i>pos-crawlerSize; i--) {
-          if (i >= 0 && i < this->size()) {
-            this->pixel(i, CRGBW{255,255,255});
-          }
-        }
 
         // BACKGROUND
-        for (int i=pos-crawlerSize; i>=0; i--) 
-            this->pixel(i, this->background);
+        Layer* back = this->solid(this->background);
+        if (back) back->end = pos-crawlerSize+1;
+
+        // CRAWLER
+        Layer* crawler = this->solid(CRGBW{255,255,255});
+        if (crawler) {
+          crawler->start = pos-crawlerSize+1;
+          crawler->end = pos+1;
+        }
 
       }
       else if (turn > position)
@@ -156,11 +165,11 @@ class Anim_cloud_crawler : public K32_anim {
         // float progx2 = (progress + (turn+round*count)%2)/2;
 
         int breath = (0.5f + 0.5f * cos(2 * PI * progress )) * 255;
-        this->all( (CRGBW) (this->background % (127+breath/2)) );
+        this->solid(this->background, BLEND_ADD, 127+breath/2);
       }
       else 
       {
-        this->all( (CRGBW) (this->background % 50) );
+        this->solid(this->background, BLEND_ADD, 50);
       }
 
 
@@ -170,12 +179,12 @@ class Anim_cloud_crawler : public K32_anim {
 
 // RAINBOW
 //
-class Anim_cloud_rainbow : public K32_anim {
+class Anim_cloud_rainbow : public Anim_cloud_layers {
   public:
     
-    void init() {}
+    void prepare() {}
 
-    void draw (int data[ANIM_DATA_SLOTS])
+    void compose (int data[ANIM_DATA_SLOTS])
     { 
       int duration = data[0];
       int time    = data[1];
@@ -186,21 +195,19 @@ class Anim_cloud_rainbow : public K32_anim {
       
       int offset = this->size() * time / duration;
       
-      CRGBW colorWheel;
-      for(int i=0; i<this->size(); i++)
-        this->pixel(i, colorWheel.setHue( 255 * ((i+offset) % this->size()) / this->size() ) );
+      this->hue(offset, this->size());
 
     }
 };
 
 // FLASH
 //
-class Anim_cloud_flash : public K32_anim {
+class Anim_cloud_flash : public Anim_cloud_layers {
   public:
     
-    void init() {}
+    void prepare() {}
 
-    void draw (int data[ANIM_DATA_SLOTS])
+    void compose (int data[ANIM_DATA_SLOTS])
     { 
       int duration = data[0];
       int time    = data[1];
@@ -211,14 +218,80 @@ class Anim_cloud_flash : public K32_anim {
       
       int offset = 100 * time / duration;
       
-      this->clear();
-      
       if (turn == position) 
       {
-        if (offset < 70) this->all( CRGBW::LightYellow );
+        if (offset < 70) this->solid( CRGBW::LightYellow );
       }
 
     }
 };
 
 
+// FLOW
+//   crawler running along the virtual strip of all clouds (one crossing per duration):
+//   every cloud draws its own slice from the shared time, color picked from round / turn.
+//
+#define FLOW_TAIL 40
+
+class Anim_cloud_flow : public Anim_cloud {
+  public:
+    void prepare() {}
+    void draw (int data[ANIM_DATA_SLOTS])
+    { 
+      int duration  = data[0];
+      int time      = data[1];
+      int round     = data[2];
+      int turn      = data[3];
+      int position  = data[4];
+      int count     = data[5];
+
+      int total = this->fullSize();
+      int head = (int64_t)time * total / duration;
+      int tail = min(FLOW_TAIL, total);
+      int levelStep = (255 << 8) / tail;
+      CRGBW color = colorPreset[(round * count + turn) % N_COLOR];
+
+      for (int i=0; i<this->size(); i++) {
+        int behind = head - (this->globalOffset + i);
+        if (behind < 0) behind += total;
+        if (behind < tail) this->pixel(i, color % (uint8_t)(255 - (behind * levelStep >> 8)));
+        else this->pixel(i, CRGBW{0,0,0});
+      }
+    }
+};
+
+
+// SWEEP
+//   front crossing the room from the pixel coordinates: x plane, y plane, then radial wave
+//   from the center (one per round), same color on all clouds.
+//
+#define SWEEP_WIDTH 80      // cm
+
+class Anim_cloud_sweep : public Anim_cloud {
+  public:
+    void prepare() {}
+    void draw (int data[ANIM_DATA_SLOTS])
+    { 
+      int duration  = data[0];
+      int time      = data[1];
+      int round     = data[2];
+      int turn      = data[3];
+      int position  = data[4];
+      int count     = data[5];
+
+      int axis = round % 3;
+      int front = (axis == 2) ? (int64_t)time * SPATIAL_ROOM / 2 / duration
+                              : (int64_t)time * SPATIAL_ROOM / duration - SPATIAL_ROOM / 2;
+      const int16_t* coord = (axis == 0) ? spatial.x : spatial.y;
+      int levelStep = (255 << 8) / SWEEP_WIDTH;
+      CRGBW color = colorPreset[round % N_COLOR];
+
+      int mapped = min(this->size(), spatial.size);
+      for (int i=0; i<mapped; i++) {
+        int distance = abs(((axis == 2) ? spatial.radius[i] : coord[i]) - front);
+        if (distance < SWEEP_WIDTH) this->pixel(i, color % (uint8_t)(255 - (distance * levelStep >> 8)));
+        else this->pixel(i, CRGBW{0,0,0});
+      }
+      for (int i=mapped; i<this->size(); i++) this->pixel(i, CRGBW{0,0,0});
+    }
+};
@@ -1,4 +1,10 @@
 #include <K32_light.h>
+#include "arena.h"
+#include "frames.h"
+#include "output.h"
+#include "outputs.h"
+#include "probe.h"
+#include "pulse.h"
 
 
 // OUTILS
@@ -14,7 +20,7 @@ enum color_mode {
   COLOR_SD        
 };
 
-CRGBW colorPreset[25] = {
+CRGBW colorPresetDmx[25] = {
   {CRGBW::Black},         // 0
   {CRGBW::Red},           // 1
   {CRGBW::Lime},          // 2
@@ -48,6 +54,220 @@ inline bool btw(int value, int min, int max) {
   return (value >= min) && (value <= max);
 }
 
+// Clamp value into [min, max]
+inline int clampInt(int value, int min, int max) {
+  return (value < min) ? min : (value > max) ? max : value;
+}
+
+// floor(k * num / den) for consecutive k, without division in the loop (k * num >= 0)
+struct Ramp {
+  int q, r, qstep, rstep, den;
+
+  Ramp(int k, int num, int d) {
+    den = (d > 0) ? d : 1;
+    q = k * num / den;
+    r = k * num % den;
+    qstep = num / den;
+    rstep = num % den;
+  }
+
+  // current value, then k+1
+  inline int up() {
+    int v = q;
+    q += qstep;
+    r += rstep;
+    int carry = (r >= den);
+    q += carry;
+    r -= carry * den;
+    return v;
+  }
+
+  // current value, then k-1
+  inline int down() {
+    int v = q;
+    q -= qstep;
+    r -= rstep;
+    int borrow = (r < 0);
+    q -= borrow;
+    r += borrow * den;
+    return v;
+  }
+};
+
+
+// PATTERN KERNELS
+//   one instance per color mode x pix mode, selected when pix mode changes.
+//   loops are split in ranges (background / dash / fade) instead of testing each pixel.
+//
+
+struct PatternParams {
+  CRGBW color[5];       // [0] = background, [1] = primary (BI) / [1-4] = dash colors (TRI / QUAD)
+  CRGBW rgbwMaster;     // PICKER
+  int hueStart;
+  int hueEnd;
+  int dashLength;
+  int dashOffset;
+  int stripeLength;     // pix mode 2: absolute dash length
+  FrameSequence* sequence;  // SD
+  uint32_t frame;
+};
+
+typedef void (*PatternKernel)(const PatternParams& p, CRGBW* segment, int size);
+
+// Primary color generator
+template<int COLOR> struct Primary {
+  CRGBW color;
+  Primary(const PatternParams& p, int size, int start) : color(p.color[1]) {}
+  inline CRGBW next() { return color; }
+};
+
+template<> struct Primary<COLOR_PICKER> {
+  Ramp hue;
+  int hueStart;
+  int sign;
+  CRGBW master;
+  CRGBW colorWheel;
+
+  Primary(const PatternParams& p, int size, int start) 
+    : hue(start, abs(p.hueEnd - p.hueStart), size), hueStart(p.hueStart), 
+      sign((p.hueEnd < p.hueStart) ? -1 : 1), master(p.rgbwMaster) {}
+
+  inline CRGBW next() { 
+    CRGBW c = colorWheel.setHue( hueStart + sign * hue.up() );
+    c %= master;
+    return c;
+  }
+};
+
+// Fade color into background (coef = 255 -> color only)
+inline CRGBW fadeTo(CRGBW color, const CRGBW& back, uint8_t coef) {
+  color %= coef;
+  color += back % (uint8_t)(255-coef);
+  return color;
+}
+
+// Color BI / PICKER x pix mode 0-5
+template<int COLOR, int PIX>
+void pixKernel(const PatternParams& p, CRGBW* segment, int size)
+{
+  const CRGBW& back = p.color[0];
+  int dashLength = p.dashLength;
+  int dashOffset = p.dashOffset;
+
+  // no pix mod: primary color
+  if (PIX == 0) {
+    Primary<COLOR> primary(p, size, 0);
+    for(int i=0; i<size; i++) segment[i] = primary.next();
+    return;
+  }
+
+  // 01:02 = primary + back dash: odd dashes (from offset) are background
+  if (PIX == 2) {
+    Primary<COLOR> primary(p, size, 0);
+    int before = clampInt(-dashOffset, 0, size);
+    for(int i=0; i<before; i++) segment[i] = primary.next();
+
+    Ramp stripe(before+dashOffset, 1, p.stripeLength);
+    for(int i=before; i<size; i++) {
+      CRGBW color = primary.next();
+      segment[i] = (stripe.up() & 1) ? back : color;
+    }
+    return;
+  }
+
+  // one-dash modes: [start, end) drawn, background elsewhere
+  int start = (PIX == 1) ? dashOffset - dashLength : dashOffset;
+  int end = (PIX == 1) ? dashOffset : dashOffset + dashLength;
+  start = clampInt(start, 0, size);
+  end = clampInt(end, start, size);
+
+  for(int i=0; i<start; i++) segment[i] = back;
+  for(int i=end; i<size; i++) segment[i] = back;
+
+  Primary<COLOR> primary(p, size, start);
+  int fade = (dashLength > 1) ? 255 : 0;
+
+  // 2 colors = primary one-dash
+  if (PIX == 1) {
+    for(int i=start; i<end; i++) segment[i] = primary.next();
+  }
+
+  // rusf> = one-dash fade R
+  else if (PIX == 3) {
+    Ramp coef(dashOffset+dashLength-1-start, fade, dashLength-1);
+    for(int i=start; i<end; i++) segment[i] = fadeTo(primary.next(), back, coef.down());
+  }
+
+  // rusf< = one-dash fade L
+  else if (PIX == 4) {
+    Ramp coef(start-dashOffset, fade, dashLength-1);
+    for(int i=start; i<end; i++) segment[i] = fadeTo(primary.next(), back, coef.up());
+  }
+
+  // rusf<> = one-dash fade LR
+  else if (PIX == 5) {
+    int half = dashLength/2;
+    int middle = clampInt(dashOffset+half, start, end);
+
+    Ramp coefL(start-dashOffset, fade, half);
+    for(int i=start; i<middle; i++) segment[i] = fadeTo(primary.next(), back, coefL.up());
+
+    Ramp coefR(dashOffset+dashLength-1-middle, fade, half);
+    for(int i=middle; i<end; i++) segment[i] = fadeTo(primary.next(), back, coefR.down());
+  }
+}
+
+// Color TRI / QUAD: multi-color dash over color[0] background
+template<int SPLIT>
+void dashKernel(const PatternParams& p, CRGBW* segment, int size)
+{
+  int dashLength = p.dashLength;
+  int dashOffset = p.dashOffset;
+
+  // pixels just before the dash round into its first part
+  int start = clampInt(dashOffset - (dashLength-1)/SPLIT, 0, size);
+  int middle = clampInt(dashOffset, start, size);
+  int end = clampInt(dashOffset + dashLength, middle, size);
+
+  for(int i=0; i<start; i++) segment[i] = p.color[0];
+  for(int i=start; i<middle; i++) segment[i] = p.color[1];
+
+  Ramp part(middle-dashOffset, SPLIT, dashLength);
+  for(int i=middle; i<end; i++) segment[i] = p.color[1 + part.up()];
+
+  for(int i=end; i<size; i++) segment[i] = p.color[0];
+}
+
+// Color SD: pre-rendered frame, channel master
+void sequenceKernel(const PatternParams& p, CRGBW* segment, int size) 
+{
+  if (!p.sequence || !p.sequence->isOpen()) {
+    for(int i=0; i<size; i++) segment[i] = CRGBW{CRGBW::Black};
+    return;
+  }
+
+  p.sequence->row(p.frame, segment, size);
+  for(int i=0; i<size; i++) segment[i] %= p.rgbwMaster;
+}
+
+PatternKernel selectKernel(int colorMode, int pixMode) 
+{
+  static const PatternKernel kernels[2][6] = {
+    { &pixKernel<COLOR_BI, 0>, &pixKernel<COLOR_BI, 1>, &pixKernel<COLOR_BI, 2>, 
+      &pixKernel<COLOR_BI, 3>, &pixKernel<COLOR_BI, 4>, &pixKernel<COLOR_BI, 5> },
+    { &pixKernel<COLOR_PICKER, 0>, &pixKernel<COLOR_PICKER, 1>, &pixKernel<COLOR_PICKER, 2>, 
+      &pixKernel<COLOR_PICKER, 3>, &pixKernel<COLOR_PICKER, 4>, &pixKernel<COLOR_PICKER, 5> }
+  };
+
+  if (colorMode == COLOR_TRI)   return &dashKernel<3>;
+  if (colorMode == COLOR_QUAD)  return &dashKernel<4>;
+  if (colorMode == COLOR_SD)    return &sequenceKernel;
+
+  int pix = (colorMode == COLOR_PICKER) ? pixMode - 6 : pixMode;
+  if (!btw(pix, 0, 5)) pix = 0;
+  return kernels[colorMode == COLOR_PICKER][pix];
+}
+
 
 // ANIM DMX
 //
@@ -164,19 +384,98 @@ en utilisant les fonctions évoquées ci-dessus.
 */
 
 
+#define PATTERN_SLOTS 13
+
 class Anim_dmx_strip : public K32_anim {
   public:
-
+    OutputLUT masterLUT;               // gamma, animMaster, white extraction as the output stage
+    ScratchArena* arena;               // render buffers, at least arenaBytes(size())
+    uint32_t (*clock)() = nullptr;     // time of the blink pulses (millis if not given)
+    
+    // Blink: multi-pulse computed from clock, needs a redraw every frame
+    MultiPulse blink;
+    int blinkMode = -1;
+    int blinkPeriod = -1;
+    bool blinking = false;
+
+    // SD: pre-rendered frames played along clock, redrawn on each new frame
+    FrameSequence* sequence = nullptr;
+    uint32_t sequenceFrame = 0;
+    bool sequencing = false;
+    
+    // Pattern cache: color / pix modes, zoom & mirror
+    CRGBW* patternBuf = nullptr;
+    const int patternSlots[PATTERN_SLOTS] = {1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15};
+    int patternKey[PATTERN_SLOTS+1];
+    int patternMode = -1;
+    PatternKernel patternKernel = nullptr;
+
+    // Capture target of render() (nullptr = strip)
+    CRGBW* canvas = nullptr;
+
+    // Modulators: resolved once, reconfigured when strobe slots change
+    K32_modulator* strobe = nullptr;
+    K32_modulator* smooth = nullptr;
+    int modMode = -1;
+    int modPeriod = -1;
+    int lastSlots[ANIM_DATA_SLOTS];         // data[1..] of last draw: mod redraw if unchanged
+
+    Probe drawProbe{"dmx draw"};
+    Probe modProbe{"dmx mod redraw"};       // draws triggered by strobe / smooth only
+    Probe patternProbe{"dmx pattern"};      // count = cache miss
+    Probe masterProbe{"dmx master"};
+
+
+    // Render buffers come from arena: pattern cache + one segment per frame
+    Anim_dmx_strip(ScratchArena* arena) : arena(arena) {}
+
+    static size_t arenaBytes(int size) {
+      return 2 * (size * sizeof(CRGBW) + alignof(CRGBW));
+    }
 
     // Setup
     void init() {
 
       // Strobe on data[0] (animMaster)
-      this->mod("strobe", new K32_mod_pulse)->param(0, STROB_ON_MS)->at(0);
+      if (!strobe) strobe = this->mod("strobe", new K32_mod_pulse)->param(0, STROB_ON_MS)->at(0);
 
       // Smooth on data[0] (animMaster)
-      this->mod("smooth", new K32_mod_sinus)->at(0);
+      if (!smooth) smooth = this->mod("smooth", new K32_mod_sinus)->at(0);
+
+      // Configure on first draw
+      modMode = -1;
+      modPeriod = -1;
+      blinkMode = -1;
+    }
+
+    // Start / stop modulators when strobe mode or period changed, true if so
+    bool modConfigure(int strobeMode, int strobePeriod)
+    {
+      if (strobeMode == modMode && strobePeriod == modPeriod) return false;
+
+      // strobe modulator
+      if (strobeMode == 1 || btw(strobeMode, 3, 10)) 
+        strobe->period( strobePeriod )->play();
+      else 
+        strobe->stop();
+
+      // smooth modulator
+      if (strobeMode == 2) 
+        smooth->period( strobePeriod )->play();
+      else 
+        smooth->stop();
 
+      modMode = strobeMode;
+      modPeriod = strobePeriod;
+      return true;
+    }
+
+    // Only the modulated master moved since last draw while a modulator runs
+    bool modRedraw(int data[ANIM_DATA_SLOTS], bool modChanged)
+    {
+      bool same = !modChanged && memcmp(lastSlots+1, data+1, sizeof(int) * (ANIM_DATA_SLOTS-1)) == 0;
+      memcpy(lastSlots+1, data+1, sizeof(int) * (ANIM_DATA_SLOTS-1));
+      return same && (modMode == 1 || btw(modMode, 2, 10));
     }
 
 
@@ -193,12 +492,23 @@ class Anim_dmx_strip : public K32_anim {
       // }
       // LOG("");
 
-      // animMaster @0 = nothing to draw
+      // STROBE (modulators on animMaster, even when it is 0)
+      /////////////////////////////////////////////////////////////////////////
+    
+      int strobeMode  = simplifyDmxRange(data[8]);
+      int strobePeriod = data[9];
+      bool modChanged = modConfigure(strobeMode, strobePeriod);
+      bool modOnly = modRedraw(data, modChanged);
+
+      // animMaster @0 = nothing to draw (strobe off phase)
       if (data[0] == 0) {
         this->clear();
+        if (modOnly) modProbe.add(0);
         return;
       }
-      
+
+      drawProbe.begin();
+
       // Mirror & Zoom -> Segment size
       int mirrorMode  = simplifyDmxRange(data[14]);
       int zoomedSize  = max(1, scale255( size(), data[15]) );
@@ -210,271 +520,249 @@ class Anim_dmx_strip : public K32_anim {
       else if (mirrorMode == 3 || mirrorMode == 6)  segmentSize /= 4;
       if (segmentSize<1) segmentSize = 1;
 
-      // Modes
-      int pixMode     = simplifyDmxRange(data[5]);
-      // LOGF("pixMode: %d\n", pixMode);
+      // PATTERN (cached, redrawn only when color / geometry slots change)
+      /////////////////////////////////////////////////////////////////////////
 
-      int colorMode = COLOR_BI;
-      if (pixMode == 23) colorMode = COLOR_TRI;
-      else if (pixMode == 24) colorMode = COLOR_QUAD;
-      else if (btw(pixMode, 6, 11)) colorMode = COLOR_PICKER; 
-      // else if (btw(pixMode, 12, 17)) colorMode = COLOR_SD;
+      // Sequence frame (color SD)
+      sequencing = sequence && btw(simplifyDmxRange(data[5]), 12, 17);
+      uint32_t frame = sequencing ? sequence->frameAt( clock ? clock() : millis() ) : 0;
 
+      bool patternMiss = patternChanged(data) || frame != sequenceFrame;
+      sequenceFrame = frame;
+      if (patternMiss) {
+        patternProbe.begin();
+        pattern(data, segmentSize);
+        patternProbe.end();
+      }
 
-      // Segment Buffer
-      CRGBW segment[segmentSize];
+      // Arena too small (overflow logged by the arena): nothing to draw
+      if (!patternBuf) {
+        drawProbe.end();
+        return;
+      }
 
 
-      // PRIMARY COLOR
+      // BLINK
       /////////////////////////////////////////////////////////////////////////
 
-      // Color mode BI
-      if (colorMode == COLOR_BI)
+      // strobe blink (3xstrobe -> blind 1+s): pulses after period*100/225, period/4, period*116/100 + 1s
+      // phased on the DMX frame that sets it: nodes receiving the same frame start together,
+      // then run on their own clock (no mesh clock in WIFI state)
+      blinking = (strobeMode == 11 || btw(strobeMode, 12, 19));
+      if (!blinking) blinkMode = -1;
+      else
       {
-        CRGBW color1 {data[1], data[2], data[3], data[4]};
-        for(int i=0; i<segmentSize; i++) segment[i] = color1;
-      }
-
-      // Color mode PICKER
-      else if (colorMode == COLOR_PICKER) {
-
-        // Hue range
-        int hueStart = data[10] + data[7];
-        int hueEnd = data[11] + data[7];
-
-        // Channel master
-        CRGBW rgbwMaster {data[1], data[2], data[3], data[4]};
+        uint32_t now = clock ? clock() : millis();
+        if (strobeMode != blinkMode || strobePeriod != blinkPeriod) {
+          uint32_t intervals[3] = { (uint32_t)strobePeriod*100/225, (uint32_t)strobePeriod/4, (uint32_t)strobePeriod*116/100 + 1000 };
+          blink.pattern(intervals, 3, STROB_ON_MS, now);
+          blinkMode = strobeMode;
+          blinkPeriod = strobePeriod;
+        }
         
-        // Color wheel
-        CRGBW colorWheel;
-        for(int i=0; i<segmentSize; i++) {
-          segment[i] = colorWheel.setHue( (hueStart + ((hueEnd - hueStart) * i) / segmentSize) );
-          segment[i] %= rgbwMaster;
+        // OFF
+        if (!blink.on(now)) {
+          this->clear();
+          drawProbe.end();
+          return;
         }
-
       }
 
-      // Color mode SD
-      else if (colorMode == COLOR_SD) {
-        // TODO: load image from SD !
 
+      // RANDOM + ANIM-MASTER
+      /////////////////////////////////////////////////////////////////////////
 
+      // Segment Buffer (released at end of draw)
+      size_t frameMark = arena->mark();
+      CRGBW* segment = arena->pixels(segmentSize);
+      if (!segment) {
+        drawProbe.end();
+        return;
       }
-      
-      // Color mode TRI / QUADRI
-      else if (colorMode == COLOR_TRI || colorMode == COLOR_QUAD) {
-        
-        // Colors
-        CRGBW color[5] = {
-          {data[10], data[11], data[12], data[13]}, // background     // color[0]
-          colorPreset[ simplifyDmxRange(data[1]) ],                   // color[1]
-          colorPreset[ simplifyDmxRange(data[2]) ],                   // color[2]
-          colorPreset[ simplifyDmxRange(data[3]) ],                   // color[3]
-          colorPreset[ simplifyDmxRange(data[4]) ]                    // color[4]
-        };
-
-        // Dash Length + Offset + Split 
-        int dashLength  = max(3, scale255(2 * segmentSize, data[6]));          
-        int dashOffset  = scale255((segmentSize-dashLength), data[7]);
-        int dashSplit = (colorMode == COLOR_QUAD) ? 4 : 3;
-        int dashPart  = 0;
-
-        // Multi-color dash / color0 backgound
-        for(int i=0; i<segmentSize; i++) 
-        {
-          dashPart = (i-dashOffset)*dashSplit/dashLength + 1;       // find in which part of the dash we are
-          if (dashPart < 0 || dashPart > dashSplit) dashPart = 0;   // use 0 if outside of the dash (=> background)
 
-          segment[i] = color[ dashPart ];
-        }          
+      // random w/ threshold
+      bool randomMode = btw(strobeMode, 3, 10) || btw(strobeMode, 12, 19) || btw(strobeMode, 20, 25);
+
+      // Seuil calculation depends of mode
+      int strobeSeuil = 1000; 
+      if (btw(strobeMode, 3, 10))       strobeSeuil = (data[8] - 31)*1000/69;         // 0->1000    strobeMode >= 3 && strobeMode <= 10
+      else if (btw(strobeMode, 12, 19)) strobeSeuil = (data[8] - 121)*1000/79;        // 0->1000    strobeMode >= 12 && strobeMode <= 19
+      else if (btw(strobeMode, 20, 25)) strobeSeuil = (data[8] - 201)*1000/54;        // 0->1000    strobeMode >= 20
+
+      // gamma + master on cached pattern (+ random black)
+      masterProbe.begin();
+      masterLUT.master(data[0]);
+      masterLUT.whiteExtract(output.rgbw);
+      if (randomMode) {
+        for(int i=0; i<segmentSize; i++) 
+          segment[i] = (random(1000) > strobeSeuil) ? CRGBW{CRGBW::Black} : masterLUT.apply(patternBuf[i]);
+      }
+      else {
+        for(int i=0; i<segmentSize; i++) segment[i] = masterLUT.apply(patternBuf[i]);
+      }
+      masterProbe.end();
 
-      }   
 
 
-      // APPLY PIX MOD BACKGROUND
+      // DRAW ON STRIP WITH ZOOM & MIRROR
       /////////////////////////////////////////////////////////////////////////
 
-      if (colorMode == COLOR_BI || colorMode == COLOR_PICKER) {
-
-        // Background Color
-        CRGBW backColor {CRGBW::Black};
-        if (colorMode == COLOR_BI) backColor = CRGBW{data[10], data[11], data[12], data[13]};
+      // Mirroring alternate (1 = copy, 2 = alternate)
+      int mirrorAlternate = 1 + btw(mirrorMode, 1, 3); 
 
-        // Dash Length + Offset
-        int dashLength  = max(1, scale255(segmentSize, data[6]) );          // pix_start
-        int dashOffset  =  scale255(segmentSize+2*dashLength, data[7])-dashLength;                  // pix_pos
-
-        // 2 colors = color1 one-dash / backColor background
-        if (pixMode == 1 || pixMode == 7) 
-        {
-          for(int i=dashLength; i<segmentSize+dashLength; i++) 
-            if (i < dashOffset || i >= dashOffset+dashLength) segment[i-dashLength] = backColor;
-        }
+      // Zoom offset
+      int zoomOffset = (size() - zoomedSize)/2;  
+      int zoomEnd = zoomOffset + zoomedSize;
 
-        // 01:02 = color1 + backColor dash 
-        if (pixMode == 2 || pixMode == 8) 
-        {
-          dashLength = max(1, data[6]);   // on this one, length is absolute and not relative to segementSize
+      // Clear margins outside of zoom
+      if (zoomOffset > 0)   this->pixel(0, zoomOffset, CRGBW{CRGBW::Black});
+      if (zoomEnd < size()) this->pixel(zoomEnd, size()-zoomEnd, CRGBW{CRGBW::Black});
 
-          for(int i=0; i<segmentSize; i++) 
-            if ( (i+dashOffset)/dashLength % 2 == 1 ) segment[i] = backColor;
-        }
+      // Copy segment blocks into strip (alternate: odd copies are reversed)
+      int copy = 0;
+      for(int start=0; start<zoomedSize; start+=segmentSize, copy++) 
+      {
+        int count = min(segmentSize, zoomedSize-start);
 
-        // rusf>  = color1 one-dash fade R / backColor background
-        else if (pixMode == 3 || pixMode == 9) 
-        {
-          for(int i=0; i<segmentSize; i++) 
-          {
-            if (i >= dashOffset && i < dashOffset+dashLength) 
-            {
-              int coef = (dashLength>1) ? ((dashOffset+dashLength-1-i) * 255 ) / (dashLength-1) : 0;
-
-              segment[i] %= (uint8_t)coef;
-              segment[i] += backColor % (uint8_t)(255-coef);
-            }
-            else segment[i] = backColor;
-          }
-        }
+        if (copy % mirrorAlternate) blitReversed(zoomOffset+start, segment, segmentSize, count);
+        else                        blit(zoomOffset+start, segment, count);
+      } 
 
-        // rusf<  = color1 one-dash fade L / color2 background
-        else if (pixMode == 4 || pixMode == 10) 
-        {
-          // LOGF("dashLength: %d\n", dashLength);
-          for(int i=0; i<segmentSize; i++) 
-          {
-            if (i >= dashOffset && i < dashOffset+dashLength) 
-            {
-              int coef = (dashLength>1) ? ((i-dashOffset) * 255 ) / (dashLength-1) : 0;
-
-              segment[i] %= (uint8_t)coef;
-              segment[i] += backColor % (uint8_t)(255-coef);
-            }
-            else segment[i] = backColor;
-          }
-          // LOG("dash done");
-        }
+      arena->release(frameMark);
 
-        // rusf<>  = color1 one-dash fade LR / color2 background
-        else if (pixMode == 5 || pixMode == 11) 
-        {
-          for(int i=0; i<segmentSize; i++) 
-          { 
-            if (i >= dashOffset && i < dashOffset+dashLength/2) 
-            {
-              int coef = (dashLength>1) ? ((i-dashOffset) * 255 ) / (dashLength/2) : 0;
-
-              segment[i] %= (uint8_t)coef;
-              segment[i] += backColor % (uint8_t)(255-coef);
-            }
-            else if (i >= dashOffset+dashLength/2 && i < dashOffset+dashLength) 
-            {
-              int coef = (dashLength>1) ? ((dashOffset+dashLength-1-i) * 255 ) / (dashLength/2) : 0;
-
-              segment[i] %= (uint8_t)coef;
-              segment[i] += backColor % (uint8_t)(255-coef);
-            }
-            else segment[i] = backColor;
-          }
-        }
+      drawProbe.end();
+      if (modOnly) modProbe.add(drawProbe.last);
+    }
 
-      }
 
+    // Drawing depends on time, not only on data
+    bool timeBased() {
+      return blinking || sequencing;
+    }
 
-      // STROBE
-      /////////////////////////////////////////////////////////////////////////
-    
-      int strobeMode  = simplifyDmxRange(data[8]);
-      int strobePeriod = data[9];
+    // Draw one frame into buf[size()] instead of strip
+    void render(int frame[ANIM_DATA_SLOTS], CRGBW* buf) {
+      canvas = buf;
+      this->draw(frame);
+      canvas = nullptr;
+    }
 
-      // strobe modulator
-      if (strobeMode == 1 || btw(strobeMode, 3, 10)) 
-        this->mod("strobe")->period( strobePeriod )->play();
-      else 
-        this->mod("strobe")->stop();
+    void clear() {
+      if (canvas) for(int i=0; i<size(); i++) canvas[i] = CRGBW{CRGBW::Black};
+      else if (outputs) outputs->all(CRGBW{CRGBW::Black});
+      else K32_anim::clear();
+    }
 
-    
-      // BLINK
-      /////////////////////////////////////////////////////////////////////////
+    void pixel(int i, CRGBW color) {
+      if (canvas) canvas[i] = color;
+      else if (outputs) outputs->pix(i, color);
+      else K32_anim::pixel(i, color);
+    }
 
-      // strobe blink (3xstrobe -> blind 1+s)
-      if (strobeMode == 11 || btw(strobeMode, 12, 19)) 
-      {
-        // int count = this->strobe->periodCount() % 3;  // ERROR: periodCount is moving.. -> count is not linear !
-        // // LOG(count);
+    void pixel(int start, int count, CRGBW color) {
+      if (canvas || outputs) for(int i=start; i<start+count; i++) this->pixel(i, color);
+      else K32_anim::pixel(start, count, color);
+    }
 
-        // if (count == 0)       this->strobe->period( strobePeriod*100/225 );
-        // else if (count == 1)  this->strobe->period( strobePeriod/4 );
-        // else if (count == 2)  this->strobe->period( strobePeriod*116/100 + 1000 );
-        
-        // // OFF
-        // if (this->strobe->value() == 0) {
-        //   this->clear();
-        //   return;
-        // }
+    // Copy count pixels of src at position start: one memcpy into a canvas,
+    // a single pass into the outputs / the strip (target resolved once per copy)
+    void blit(int start, const CRGBW* src, int count) 
+    {
+      if (canvas) memcpy(canvas + start, src, count * sizeof(CRGBW));
+      else if (outputs) for(int i=0; i<count; i++) outputs->pix(start+i, src[i]);
+      else for(int i=0; i<count; i++) K32_anim::pixel(start+i, src[i]);
+    }
 
-        // TODO: make a special "multi-pulse" modulator
+    // Same with src[size] read backward from its end
+    void blitReversed(int start, const CRGBW* src, int size, int count) 
+    {
+      const CRGBW* from = src + size - 1;
+      if (canvas) {
+        CRGBW* to = canvas + start;
+        for(int i=0; i<count; i++) to[i] = from[-i];
       }
+      else if (outputs) for(int i=0; i<count; i++) outputs->pix(start+i, from[-i]);
+      else for(int i=0; i<count; i++) K32_anim::pixel(start+i, from[-i]);
+    }
 
 
-      // SMOOTH
-      /////////////////////////////////////////////////////////////////////////
-
-      // smooth modulator
-      if (strobeMode == 2) 
-        this->mod("smooth")->period( strobePeriod )->play();
-      else 
-        this->mod("smooth")->stop();
+    // Check if slots used by pattern() changed since last call
+    bool patternChanged(int data[ANIM_DATA_SLOTS]) 
+    {
+      bool changed = !patternBuf || patternKey[0] != size();
+      patternKey[0] = size();
 
-      
-      // RANDOM
-      /////////////////////////////////////////////////////////////////////////
+      for (int k=0; k<PATTERN_SLOTS; k++) {
+        int value = data[ patternSlots[k] ];
+        if (patternKey[k+1] != value) changed = true;
+        patternKey[k+1] = value;
+      }
+      return changed;
+    }
 
-      // random w/ threshold
-      if (btw(strobeMode, 3, 10) || btw(strobeMode, 12, 19) || btw(strobeMode, 20, 25)) 
-      {
-        // Seuil calculation depends of mode
-        int strobeSeuil = 1000; 
-        if (btw(strobeMode, 3, 10))       strobeSeuil = (data[8] - 31)*1000/69;         // 0->1000    strobeMode >= 3 && strobeMode <= 10
-        else if (btw(strobeMode, 12, 19)) strobeSeuil = (data[8] - 121)*1000/79;        // 0->1000    strobeMode >= 12 && strobeMode <= 19
-        else if (btw(strobeMode, 20, 25)) strobeSeuil = (data[8] - 201)*1000/54;        // 0->1000    strobeMode >= 20
 
-        // apply random Seuil
-        for(int i=0; i<segmentSize; i++) 
-          if (random(1000) > strobeSeuil) segment[i] = {CRGBW::Black};
-      }
+    // Draw color / pix modes into patternBuf (before strobe & master)
+    void pattern(int data[ANIM_DATA_SLOTS], int segmentSize) 
+    {
+      // Modes
+      int pixMode     = simplifyDmxRange(data[5]);
+      // LOGF("pixMode: %d\n", pixMode);
 
+      int colorMode = COLOR_BI;
+      if (pixMode == 23) colorMode = COLOR_TRI;
+      else if (pixMode == 24) colorMode = COLOR_QUAD;
+      else if (btw(pixMode, 6, 11)) colorMode = COLOR_PICKER; 
+      else if (btw(pixMode, 12, 17)) colorMode = COLOR_SD;
 
-      // ANIM-MASTER
-      /////////////////////////////////////////////////////////////////////////
+      // Kernel
+      if (pixMode != patternMode) {
+        patternKernel = selectKernel(colorMode, pixMode);
+        patternMode = pixMode;
+      }
 
-      for(int i=0; i<segmentSize; i++) segment[i] %= (uint8_t)data[0];
+      // Pattern Buffer
+      if (!patternBuf) patternBuf = arena->pixels(size());
+      if (!patternBuf) return;
 
+      PatternParams p;
 
+      // Color mode TRI / QUADRI
+      if (colorMode == COLOR_TRI || colorMode == COLOR_QUAD) 
+      {
+        p.color[0] = CRGBW{data[10], data[11], data[12], data[13]};         // background
+        for (int k=1; k<5; k++) p.color[k] = colorPresetDmx[ simplifyDmxRange(data[k]) ];
 
-      // DRAW ON STRIP WITH ZOOM & MIRROR
-      /////////////////////////////////////////////////////////////////////////
+        // Dash Length + Offset
+        p.dashLength  = max(3, scale255(2 * segmentSize, data[6]));          
+        p.dashOffset  = scale255((segmentSize-p.dashLength), data[7]);
+      }
 
-      // Clear
-      this->clear();
+      // Color mode BI / PICKER
+      else 
+      {
+        // Primary color / Channel master
+        p.color[1] = CRGBW{data[1], data[2], data[3], data[4]};
+        p.rgbwMaster = p.color[1];
 
-      // Mirroring alternate (1 = copy, 2 = alternate)
-      int mirrorAlternate = 1 + btw(mirrorMode, 1, 3); 
+        // Hue range
+        p.hueStart = data[10] + data[7];
+        p.hueEnd = data[11] + data[7];
 
-      // Zoom offset
-      int zoomOffset = (size() - zoomedSize)/2;  
+        // Background Color
+        p.color[0] = CRGBW{CRGBW::Black};
+        if (colorMode == COLOR_BI) p.color[0] = CRGBW{data[10], data[11], data[12], data[13]};
 
-      // Copy pixels into strip
-      for(int i=0; i<zoomedSize; i++) 
-      {
-        int pix  = i % segmentSize;               // pix cursor into segment
-        int iter = i / segmentSize;               // count of mirror copy 
-        
-        if (iter && iter % mirrorAlternate)       // alternate: invert pix cursor
-          pix = segmentSize - pix - 1;    
+        // Dash Length + Offset
+        p.dashLength  = max(1, scale255(segmentSize, data[6]) );                              // pix_start
+        p.dashOffset  = scale255(segmentSize+2*p.dashLength, data[7])-p.dashLength;           // pix_pos
+        p.stripeLength = max(1, data[6]);     // pix mode 2: length is absolute and not relative to segementSize
 
-        this->pixel(i+zoomOffset, segment[pix]);  // draw on strip
-      } 
+        // Sequence
+        p.sequence = sequence;
+        p.frame = sequenceFrame;
+      }
 
+      patternKernel(p, patternBuf, segmentSize);
     }
 
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef arena_h
+#define arena_h
+
+#include <K32_light.h>
+
+// SCRATCH ARENA
+//   one block allocated at setup, cut into aligned render buffers:
+//     - long lived buffers (pattern cache, fade buffers...) with pixels() at setup / first draw
+//     - per-frame buffers between mark() and release(mark)
+//   nothing is allocated while drawing, highWater gives the size really needed.
+//
+class ScratchArena {
+  public:
+    uint8_t* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t highWater = 0;
+
+    ScratchArena(size_t bytes) {
+      base = (uint8_t*)malloc(bytes);
+      if (base) capacity = bytes;
+      else LOG("ARENA: allocation failed");
+    }
+
+    void* take(size_t bytes, size_t align = 4) {
+      size_t start = (used + align - 1) & ~(align - 1);
+      if (start + bytes > capacity) {
+        Serial.printf("ARENA: overflow, %u bytes requested, %u / %u used\n", (unsigned)bytes, (unsigned)used, (unsigned)capacity);
+        return nullptr;
+      }
+      used = start + bytes;
+      if (used > highWater) highWater = used;
+      return base + start;
+    }
+
+    CRGBW* pixels(int count) {
+      return (CRGBW*)take(count * sizeof(CRGBW), alignof(CRGBW));
+    }
+
+    size_t mark() {
+      return used;
+    }
+
+    void release(size_t m) {
+      used = m;
+    }
+
+    void log() {
+      Serial.printf("ARENA: %u / %u bytes, high-water %u\n", (unsigned)used, (unsigned)capacity, (unsigned)highWater);
+    }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef artnet_h
+#define artnet_h
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <K32_light.h>
+#include "probe.h"
+
+// ARTNET INPUT
+//   ArtDMX packets are parsed from the UDP socket straight into the anim data slots (set),
+//   only the header and the bytes up to the end of the patch are read.
+//   Slots past the DMX length or the end of the packet are not read: a packet too short
+//   for the patch is ignored.
+//   Stale / out-of-order packets are dropped using the sequence number,
+//   bursts are coalesced: the anim is pushed at most ARTNET_FPS times per second.
+//
+
+#define ARTNET_PORT       6454
+#define ARTNET_HEADER     18
+#define ARTNET_OPDMX      0x5000
+#define ARTNET_FPS        50
+#define ARTNET_TIMEOUT    2000      // ms without valid packet => sequence reset, not receiving
+#define ARTNET_SKIP       32        // chunk used to skip the slots before address
+
+class ArtnetInput {
+  public:
+    ArtnetInput(K32_anim* anim, int universe, int address, int slots)
+    {
+      this->anim = anim;
+      this->universe = universe;
+      this->address = address;
+      this->slots = min(slots, ANIM_DATA_SLOTS);
+    }
+
+    void begin() {
+      udp.begin(ARTNET_PORT);
+      statsAt = millis();
+    }
+
+    // Read pending packets, push latest frame to anim
+    void update()
+    {
+      while (int length = udp.parsePacket())
+      {
+        packets++;
+        uint32_t now = millis();
+
+        // Header
+        uint8_t header[ARTNET_HEADER];
+        if (length < ARTNET_HEADER || udp.read(header, ARTNET_HEADER) != ARTNET_HEADER
+            || memcmp(header, "Art-Net", 8) != 0
+            || (header[8] | header[9] << 8) != ARTNET_OPDMX
+            || (header[14] | header[15] << 8) != universe)
+        {
+          ignored++;
+          udp.flush();
+          continue;
+        }
+
+        // DMX slots in this packet: declared length, bounded by the bytes really received
+        int dmxLength = min(header[16] << 8 | header[17], min(length - ARTNET_HEADER, 512));
+        int count = min(slots, dmxLength - address);
+        if (count <= 0) {
+          ignored++;
+          udp.flush();
+          continue;
+        }
+
+        // Sequence (0 = disabled): drop duplicates and older packets
+        uint8_t sequence = header[12];
+        if (sequence && lastSequence && now - lastPacketAt < ARTNET_TIMEOUT && (int8_t)(sequence - lastSequence) <= 0) {
+          drops++;
+          udp.flush();
+          continue;
+        }
+        lastSequence = sequence;
+        lastPacketAt = now;
+
+        // DMX slots -> anim data, read up to the end of the patch only
+        uint8_t dmx[ARTNET_SKIP];
+        for (int skip = address; skip > 0; skip -= ARTNET_SKIP)
+          udp.read(dmx, min(skip, ARTNET_SKIP));
+        for (int i=0; i<count; i++)
+          anim->set(i, udp.read());
+        udp.flush();
+
+        if (!pending) receivedAt = micros();
+        pending = true;
+      }
+
+      // Coalesce to render rate
+      if ((pending || refreshing) && millis() - pushedAt >= 1000/ARTNET_FPS) {
+        anim->push();
+        pushedAt = millis();
+        if (pending) latency.add(micros() - receivedAt);
+        frames++;
+        pending = refreshing = false;
+      }
+    }
+
+    // Redraw on next frame even without new packet (time based anim)
+    void refresh() {
+      refreshing = true;
+    }
+
+    bool isReceiving() {
+      return lastPacketAt > 0 && millis() - lastPacketAt < ARTNET_TIMEOUT;
+    }
+
+    // Log rates since last call
+    void log()
+    {
+      uint32_t elapsed = max((uint32_t)1, millis() - statsAt);
+      Serial.printf("ARTNET: %u pkt/s, %u frames/s, %u dropped, %u ignored\n",
+                      packets*1000/elapsed, frames*1000/elapsed, drops, ignored);
+      packets = frames = drops = ignored = 0;
+      statsAt = millis();
+    }
+
+    uint32_t packets = 0;
+    uint32_t frames = 0;
+    uint32_t drops = 0;
+    uint32_t ignored = 0;
+    Probe latency{"artnet latency"};      // packet received -> anim pushed
+
+  private:
+    WiFiUDP udp;
+    K32_anim* anim;
+    int universe;
+    int address;
+    int slots;
+
+    uint8_t lastSequence = 0;
+    uint32_t lastPacketAt = 0;
+    uint32_t receivedAt = 0;
+    uint32_t pushedAt = 0;
+    uint32_t statsAt = 0;
+    bool pending = false;
+    bool refreshing = false;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef bench_h
+#define bench_h
+
+// BENCHMARK (include after light.h)
+//   renders every macro off-strip into scratch canvases of several sizes,
+//   cross-fades each macro into the next one on strip,
+//   times the output stage (gamma LUT + master multiply) against the plain '%= master' pass,
+//   then sweeps the DMX strip pix modes, one CSV line per case on serial:
+//     BENCH,<anim>,<size>,<param>,<frames>,<ns/pixel>,<fps>,<heap used>
+//   param: peers for macros, incoming macro for fade, master changing each frame (strobe) for output,
+//          data[5] for dmx (+1000 = pattern redrawn each frame).
+//   collect with:  pio device monitor | grep BENCH > bench.csv
+//   or on host:    pio run -e bench -t exec | grep BENCH > bench.csv   (test/bench, sizes up to 3000)
+//
+
+#define BENCH_FRAMES  200
+#define BENCH_STEP    20        // ms of show time between frames
+
+const int benchSizes[] = {25, 150, 750, 3000};     // up to stripSIZE
+const int benchPeers[] = {1, 4};
+
+void benchLine(String anim, int size, int param, uint32_t us, int heapBefore)
+{
+  uint32_t pixels = BENCH_FRAMES * size;
+  if (us == 0) us = 1;
+  Serial.printf("BENCH,%s,%d,%d,%d,%u,%u,%d\n", anim.c_str(), size, param, BENCH_FRAMES,
+                  (uint32_t)((uint64_t)us * 1000 / pixels),
+                  (uint32_t)((uint64_t)BENCH_FRAMES * 1000000 / us),
+                  heapBefore - (int)ESP.getFreeHeap());
+}
+
+// Macros: BENCH_FRAMES of show time, at position 0
+void benchMacros()
+{
+  int frame[ANIM_DATA_SLOTS] = {0};
+
+  for (int n=0; n<macroCount; n++)
+    for (int size : benchSizes)
+      for (int peers : benchPeers)
+      {
+        if (size > stripSIZE) continue;
+        size_t mark = scratch->mark();
+        CRGBW* canvas = scratch->pixels(size);
+        if (!canvas) continue;
+
+        int heap = ESP.getFreeHeap();
+        anims[n]->init();
+
+        uint32_t start = micros();
+        for (int f=0; f<BENCH_FRAMES; f++) {
+          macroFrame(n, 0, f * BENCH_STEP, 0, peers, frame);
+          anims[n]->render(frame, canvas, size);
+        }
+        benchLine("macro_"+String(n), size, peers, micros() - start, heap);
+
+        scratch->release(mark);
+      }
+}
+
+// Macro fade on strip: each macro fading into the next one (param: incoming macro)
+void benchFade()
+{
+  int frame[ANIM_DATA_SLOTS] = {0};
+
+  for (int n=0; n+1<macroCount; n++)
+  {
+    int heap = ESP.getFreeHeap();
+    fade->from = anims[n];
+    fade->to = anims[n+1];
+    anims[n]->init();
+    anims[n+1]->init();
+
+    uint32_t start = micros();
+    for (int f=0; f<BENCH_FRAMES; f++) {
+      frame[0] = f * 256 / BENCH_FRAMES;
+      macroFrame(n, 0, f * BENCH_STEP, 0, 1, &frame[1]);
+      macroFrame(n+1, 0, f * BENCH_STEP, 0, 1, &frame[7]);
+      fade->draw(frame);
+    }
+    benchLine("fade", stripSIZE, n+1, micros() - start, heap);
+  }
+  fade->from = fade->to = nullptr;
+}
+
+inline uint8_t gammaPow(uint8_t v) {
+  return (uint8_t)(255.0f * powf(v/255.0f, OUTPUT_GAMMA) + 0.5f);
+}
+
+// Output stage (gamma tables + master) against the same gamma computed per value then '%=' (output_pow),
+// and '%=' alone without gamma (output_mod, floor): master fixed (param 0) or changing on every frame as under strobe (param 1)
+void benchOutput()
+{
+  OutputLUT stage;
+
+  for (int size : benchSizes)
+  {
+    if (size > stripSIZE) continue;
+    size_t mark = scratch->mark();
+    CRGBW* src = scratch->pixels(size);
+    CRGBW* dst = scratch->pixels(size);
+    if (!src || !dst) continue;
+    for (int i=0; i<size; i++) src[i] = CRGBW{ i % 256, (i*7) % 256, 255 - i % 256, (i*3) % 256 };
+
+    for (int strobe=0; strobe<2; strobe++)
+      for (int path=0; path<3; path++)
+      {
+        int heap = ESP.getFreeHeap();
+        uint32_t start = micros();
+        for (int f=0; f<BENCH_FRAMES; f++) {
+          uint8_t master = strobe ? (f * 37) % 256 : 180;
+          if (path == 0) {
+            stage.master(master);
+            for (int i=0; i<size; i++) dst[i] = stage.apply(src[i]);
+          }
+          else if (path == 1)
+            for (int i=0; i<size; i++) {
+              dst[i] = CRGBW{ gammaPow(src[i].r), gammaPow(src[i].g), gammaPow(src[i].b), gammaPow(src[i].w) };
+              dst[i] %= master;
+            }
+          else
+            for (int i=0; i<size; i++) { dst[i] = src[i]; dst[i] %= master; }
+        }
+        benchLine(path == 0 ? "output_lut" : path == 1 ? "output_pow" : "output_mod", size, strobe, micros() - start, heap);
+      }
+
+    scratch->release(mark);
+  }
+}
+
+// DMX strip: every pix mode on strip size, cached pattern then pattern miss on each frame
+void benchDmx(Anim_dmx_strip* dmx)
+{
+  int data[ANIM_DATA_SLOTS] = {0};
+  data[0] = 255;                // master
+  data[1] = 255;                // red
+  data[2] = 80;                 // green
+  data[5] = 0;                  // pix mode
+  data[6] = 60;                 // length
+  data[12] = 40;                // background blue
+  data[15] = 255;               // zoom
+
+  dmx->init();
+  for (int pix=0; pix<18; pix++)
+    for (int miss=0; miss<2; miss++)
+    {
+      data[5] = pix*10 + 1;
+      int heap = ESP.getFreeHeap();
+
+      uint32_t start = micros();
+      for (int f=0; f<BENCH_FRAMES; f++) {
+        data[7] = miss ? f % 256 : 0;     // offset: pattern slot
+        dmx->draw(data);
+      }
+      benchLine("dmx", dmx->size(), data[5] + miss*1000, micros() - start, heap);
+    }
+  dmx->clear();
+}
+
+// DMX strips of different sizes
+void benchRun(Anim_dmx_strip* dmx[], int count)
+{
+  LOG("BENCH: anim,size,param,frames,ns_per_pixel,fps,heap_used");
+  benchMacros();
+  benchFade();
+  benchOutput();
+  for (int k=0; k<count; k++) benchDmx(dmx[k]);
+  LOG("BENCH: done");
+}
+
+#endif
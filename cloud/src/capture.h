@@ -0,0 +1,219 @@
+#ifndef capture_h
+#define capture_h
+
+#include <Arduino.h>
+#include "probe.h"
+
+// MESH CAPTURE
+//   timestamped mesh events (receive, send, topology change, time adjust) appended
+//   to a binary ring, oldest events dropped when full. Shared by cloud and bridge.
+//
+//   event (little endian): local µs (u32)  mesh ms (u32)  type (u8)  reserved (u8)  length (u16)
+//                          node (u32)  value (i32)  payload (length bytes)
+//     RECV / SEND: node = from / to (0 = broadcast), payload = message
+//     TOPOLOGY:    value = node count, payload = node ids (u32)
+//     TIME:        value = offset (µs)
+//
+//   dump() prints the ring as hex lines between "CAPTURE <bytes>" and "CAPTURE end",
+//   load() reads the same block back (cloud/capture extract), replay() dispatches the
+//   events at their recorded pace with the recorded mesh time.
+//
+
+#define CAPTURE_SIZE      16384
+#define CAPTURE_HEADER    20
+#define CAPTURE_PAYLOAD   1024
+#define CAPTURE_LINE      32        // bytes per dump line
+
+enum capture_event {
+  CAPTURE_RECV = 1,
+  CAPTURE_SEND,
+  CAPTURE_TOPOLOGY,
+  CAPTURE_TIME
+};
+
+struct CaptureEvent {
+  uint32_t local;
+  uint32_t mesh;
+  uint8_t type;
+  uint16_t length;
+  uint32_t node;
+  int32_t value;
+};
+
+class CaptureRing {
+  public:
+    uint32_t (*clock)() = nullptr;      // mesh time (ms)
+    uint32_t events = 0;
+    uint32_t dropped = 0;
+    Probe probe{"capture"};
+
+    CaptureRing(size_t bytes = CAPTURE_SIZE) {
+      buf = (uint8_t*)malloc(bytes);
+      if (buf) size = bytes;
+      else Serial.println("CAPTURE: allocation failed");
+    }
+
+    void record(uint8_t type, uint32_t node, int32_t value, const uint8_t* payload, size_t length)
+    {
+      if (length > CAPTURE_PAYLOAD) length = CAPTURE_PAYLOAD;
+      size_t n = CAPTURE_HEADER + length;
+      if (n > size) return;
+
+      probe.begin();
+      while (used + n > size) drop();
+
+      uint8_t header[CAPTURE_HEADER];
+      put32(header, micros());
+      put32(header + 4, clock ? clock() : millis());
+      header[8] = type;
+      header[9] = 0;
+      header[10] = length;
+      header[11] = length >> 8;
+      put32(header + 12, node);
+      put32(header + 16, value);
+      write(header, CAPTURE_HEADER);
+      write(payload, length);
+      events++;
+      probe.end();
+    }
+
+    void record(uint8_t type, uint32_t node, const String& msg) {
+      record(type, node, 0, (const uint8_t*)msg.c_str(), msg.length());
+    }
+
+    void clear() {
+      head = tail = used = 0;
+      events = dropped = 0;
+    }
+
+    // Hex dump on serial, oldest first
+    void dump()
+    {
+      Serial.printf("CAPTURE %u\n", (unsigned)used);
+      char line[2*CAPTURE_LINE + 1];
+      for (size_t i=0; i<used; i+=CAPTURE_LINE) {
+        size_t n = min((size_t)CAPTURE_LINE, used-i);
+        for (size_t k=0; k<n; k++) sprintf(line + 2*k, "%02x", at(i+k));
+        Serial.println(line);
+      }
+      Serial.println("CAPTURE end");
+    }
+
+    // Read a dump block from serial (header line already consumed)
+    bool load(size_t bytes)
+    {
+      clear();
+      if (bytes > size) return false;
+      while (used < bytes) {
+        String line = Serial.readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0 || line.startsWith("CAPTURE")) break;
+        for (unsigned int k=0; k+1 < line.length() && used < bytes; k+=2) {
+          uint8_t b = strtoul(line.substring(k, k+2).c_str(), NULL, 16);
+          write(&b, 1);
+        }
+      }
+      return used == bytes;
+    }
+
+    // Event at ring offset pos (from oldest), payload copied to out[CAPTURE_PAYLOAD]
+    bool read(size_t& pos, CaptureEvent& ev, uint8_t* out)
+    {
+      if (pos + CAPTURE_HEADER > used) return false;
+      uint8_t header[CAPTURE_HEADER];
+      for (int k=0; k<CAPTURE_HEADER; k++) header[k] = at(pos+k);
+      ev.local = get32(header);
+      ev.mesh = get32(header + 4);
+      ev.type = header[8];
+      ev.length = header[10] | header[11] << 8;
+      ev.node = get32(header + 12);
+      ev.value = get32(header + 16);
+      if (pos + CAPTURE_HEADER + ev.length > used) return false;
+      for (int k=0; k<ev.length; k++) out[k] = at(pos + CAPTURE_HEADER + k);
+      pos += CAPTURE_HEADER + ev.length;
+      return true;
+    }
+
+    // REPLAY
+    bool replaying = false;
+
+    void replayStart() {
+      replayPos = 0;
+      replaying = (used > 0);
+      replayFirst = true;
+    }
+
+    // Dispatch due events, call often
+    void replay(void (*dispatch)(const CaptureEvent& ev, uint8_t* payload))
+    {
+      static uint8_t payload[CAPTURE_PAYLOAD + 1];
+      while (replaying) {
+        size_t pos = replayPos;
+        CaptureEvent ev;
+        if (!read(pos, ev, payload)) {
+          replaying = false;
+          Serial.println("CAPTURE: replay done");
+          return;
+        }
+        if (replayFirst) {
+          replayLocal = micros() - ev.local;
+          replayFirst = false;
+        }
+        if ((int32_t)(micros() - replayLocal - ev.local) < 0) return;
+
+        replayMesh = ev.mesh;
+        replayMeshAt = millis();
+        payload[ev.length] = 0;
+        replayPos = pos;
+        dispatch(ev, payload);
+      }
+    }
+
+    // Mesh time during replay: recorded time of last event + elapsed
+    uint32_t replayMillis() {
+      return replayMesh + (millis() - replayMeshAt);
+    }
+
+  private:
+    uint8_t* buf = nullptr;
+    size_t size = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t used = 0;
+
+    size_t replayPos = 0;
+    bool replayFirst = true;
+    uint32_t replayLocal = 0;
+    uint32_t replayMesh = 0;
+    uint32_t replayMeshAt = 0;
+
+    inline uint8_t at(size_t i) {
+      return buf[(tail + i) % size];
+    }
+
+    void write(const uint8_t* p, size_t n) {
+      for (size_t k=0; k<n; k++) {
+        buf[head] = p[k];
+        if (++head == size) head = 0;
+      }
+      used += n;
+    }
+
+    // Drop oldest event
+    void drop() {
+      size_t n = CAPTURE_HEADER + (at(10) | at(11) << 8);
+      tail = (tail + n) % size;
+      used -= n;
+      dropped++;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+      p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+    }
+
+    static uint32_t get32(const uint8_t* p) {
+      return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef compositor_h
+#define compositor_h
+
+#include "anim_cloud.h"
+#include "probe.h"
+
+// COMPOSITOR
+//   a stack of layers (generator + pixel range + blend mode + master)
+//   rendered in one pass: each strip pixel is computed through all layers, then written once
+//   (once per span of pixels covered by the same solid layers).
+//
+
+#define LAYERS_MAX 4
+
+enum layer_gen {
+  GEN_SOLID,      // color
+  GEN_HUE         // color wheel, rolling by offset
+};
+
+enum layer_blend {
+  BLEND_ALPHA,    // master is the opacity of the layer
+  BLEND_ADD,
+  BLEND_MULTIPLY,
+  BLEND_MAX
+};
+
+struct Layer {
+  uint8_t gen = GEN_SOLID;
+  uint8_t blend = BLEND_ALPHA;
+  uint8_t master = 255;
+  int start = 0;            // pixel range [start, end)
+  int end = 0;
+  CRGBW color;              // GEN_SOLID
+  int hueOffset = 0;        // GEN_HUE
+  int hueSpan = 1;
+};
+
+Probe layersProbe("layers");
+
+class Anim_cloud_layers : public Anim_cloud {
+  public:
+    Layer layers[LAYERS_MAX];
+    int layerCount = 0;
+    bool overflow = false;    // logged once
+
+    // Build the layer stack of this frame
+    virtual void compose(int data[ANIM_DATA_SLOTS]) = 0;
+
+    // Add a full size layer on top of the stack (nullptr if the stack is full: layer dropped)
+    Layer* layer(uint8_t gen, uint8_t blend = BLEND_ALPHA, uint8_t master = 255) {
+      if (layerCount == LAYERS_MAX) {
+        if (!overflow) LOGF("COMPOSITOR: more than %d layers, layer dropped\n", LAYERS_MAX);
+        overflow = true;
+        return nullptr;
+      }
+      Layer* l = &layers[layerCount++];
+      *l = Layer();
+      l->gen = gen;
+      l->blend = blend;
+      l->master = master;
+      l->end = this->size();
+      return l;
+    }
+
+    Layer* solid(CRGBW color, uint8_t blend = BLEND_ALPHA, uint8_t master = 255) {
+      Layer* l = layer(GEN_SOLID, blend, master);
+      if (l) l->color = color;
+      return l;
+    }
+
+    Layer* hue(int offset, int span, uint8_t blend = BLEND_ALPHA, uint8_t master = 255) {
+      Layer* l = layer(GEN_HUE, blend, master);
+      if (!l) return nullptr;
+      l->hueOffset = offset;
+      l->hueSpan = max(1, span);
+      return l;
+    }
+
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      layersProbe.begin();
+
+      layerCount = 0;
+      this->compose(data);
+
+      // Solid layers: color and master are resolved once per frame
+      CRGBW scaled[LAYERS_MAX];
+      for (int l=0; l<layerCount; l++) {
+        scaled[l] = layers[l].color;
+        if (layers[l].blend != BLEND_ALPHA) scaled[l] %= layers[l].master;
+      }
+
+      // Spans between layer bounds: the same layers cover every pixel of a span,
+      // a span without hue layer is one color, blended once
+      int size = this->size();
+      int bounds[2*LAYERS_MAX+2];
+      int count = 0;
+      bounds[count++] = 0;
+      bounds[count++] = size;
+      for (int l=0; l<layerCount; l++) {
+        bounds[count++] = constrain(layers[l].start, 0, size);
+        bounds[count++] = constrain(layers[l].end, 0, size);
+      }
+      for (int k=1; k<count; k++)
+        for (int j=k; j>0 && bounds[j-1] > bounds[j]; j--) std::swap(bounds[j-1], bounds[j]);
+
+      for (int k=0; k+1<count; k++)
+      {
+        int from = bounds[k];
+        int to = bounds[k+1];
+        if (from == to) continue;
+
+        bool flat = true;
+        for (int l=0; l<layerCount; l++)
+          if (layers[l].gen == GEN_HUE && from >= layers[l].start && from < layers[l].end) flat = false;
+
+        if (flat) {
+          CRGBW pix = compute(from, scaled);
+          for (int i=from; i<to; i++) this->pixel(i, pix);
+        }
+        else
+          for (int i=from; i<to; i++) this->pixel(i, compute(i, scaled));
+      }
+
+      layersProbe.end();
+    }
+
+    // Pixel i through all layers
+    CRGBW compute(int i, const CRGBW scaled[])
+    {
+      CRGBW pix {0,0,0,0};
+      CRGBW colorWheel;
+
+      for (int l=0; l<layerCount; l++)
+      {
+        const Layer& L = layers[l];
+        if (i < L.start || i >= L.end) continue;
+
+        CRGBW c = scaled[l];
+        if (L.gen == GEN_HUE) {
+          c = colorWheel.setHue( 255 * ((i+L.hueOffset) % L.hueSpan) / L.hueSpan );
+          if (L.blend != BLEND_ALPHA) c %= L.master;
+        }
+
+        blend(pix, c, L.blend, L.master);
+      }
+      return pix;
+    }
+
+    static void blend(CRGBW& dst, const CRGBW& src, uint8_t mode, uint8_t master)
+    {
+      dst = CRGBW{ channel(dst.r, src.r, mode, master),
+                   channel(dst.g, src.g, mode, master),
+                   channel(dst.b, src.b, mode, master),
+                   channel(dst.w, src.w, mode, master) };
+    }
+
+    static inline uint8_t channel(int d, int s, uint8_t mode, uint8_t master)
+    {
+      if (mode == BLEND_ALPHA)          return (master == 255) ? s : (d * (255-master) + s * master) / 255;
+      else if (mode == BLEND_ADD)       return min(255, d + s);
+      else if (mode == BLEND_MULTIPLY)  return d * s / 255;
+      else                              return max(d, s);
+    }
+};
+
+#endif
@@ -0,0 +1,462 @@
+#ifndef firmware_h
+#define firmware_h
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include "transport.h"
+
+// FIRMWARE SHARE
+//   firmware images spread node to node over the mesh (no router, no WIFI state):
+//     FH=<version>,<size>,<hash>,<have>,<bitmap|*>   status: image I have (* = all chunks)
+//     FH=0                                            I don't share (bridge): not waited for
+//     FR=<hash>,<chunk>                               request a chunk, to a node that has it
+//     FD=<hash>,<chunk>,<chunkhash>,<data>            chunk, base64
+//   Every node offers its running image every FW_OFFER_MS. A node hearing a newer version
+//   stages it into the inactive OTA partition: chunks in any order (a flash sector is erased
+//   with its first chunk), FW_INFLIGHT requests at a time spread over the nodes that have them,
+//   re-requested elsewhere after a timeout following the round trip (no congestion collapse). While staging, status goes out every FW_STATUS_MS
+//   (+ FW_STATUS_NODE per node), so partial nodes serve their chunks too. Progress is kept in flash
+//   (Preferences "firmware"): a reboot resumes. Once the image checks against its hash and every node of the mesh reports
+//   it complete, the node boots it: a node not heard yet (or an older firmware that doesn't share) holds the switch,
+//   only FH=0 ones are not waited for. Hashes: FNV-1a 32. Propagation model: cloud/meshota.
+//
+
+#define FW_CHUNK        1024
+#define FW_SECTOR       4096
+#define FW_MAX_CHUNKS   1280        // 0x140000 app partition
+#define FW_BITMAP       (FW_MAX_CHUNKS / 8)
+#define FW_NODES        128         // status per node of the mesh (fleet complete)
+#define FW_PEERS        16          // chunk bitmaps of the last nodes heard (request sources)
+#define FW_INFLIGHT     4
+#define FW_TIMEOUT_MS   1500        // min request timeout, 2x measured round trip otherwise
+#define FW_TIMEOUT_MAX  20000
+#define FW_ASKED        16          // last requests, round trip of late answers too
+#define FW_STATUS_MS    2000
+#define FW_STATUS_NODE  250         // + per node in the mesh: statuses are relayed by every node
+#define FW_OFFER_MS     60000
+#define FW_SWITCH_MS    5000        // fleet complete -> boot new image
+#define FW_SAVE_CHUNKS  64          // progress saved every n chunks
+
+struct FirmwareNode {
+  uint32_t node = 0;
+  uint32_t hash = 0;
+  bool all = false;
+  bool silent = false;      // FH=0
+  uint32_t seenAt = 0;
+};
+
+struct FirmwarePeer {
+  uint32_t node = 0;
+  uint32_t hash = 0;
+  int have = 0;
+  bool all = false;
+  uint8_t bitmap[FW_BITMAP];
+  uint32_t seenAt = 0;
+};
+
+class FirmwareShare {
+  public:
+    // Running image
+    int version = 0;
+    uint32_t size = 0;
+    uint32_t hash = 0;
+
+    // Staged image
+    int targetVersion = 0;
+    uint32_t targetSize = 0;
+    uint32_t targetHash = 0;
+    int chunks = 0;
+    int have = 0;
+    bool complete = false;
+    uint32_t switchAt = 0;
+
+    uint32_t requests = 0;
+    uint32_t timeouts = 0;
+    uint32_t rtt = 0;
+    uint32_t timeout = FW_TIMEOUT_MS;
+    uint32_t served = 0;
+    uint32_t rejected = 0;
+
+    void begin(int runningVersion)
+    {
+      version = runningVersion;
+      running = esp_ota_get_running_partition();
+      staging = esp_ota_get_next_update_partition(NULL);
+      size = ESP.getSketchSize();
+      hash = imageHash(running, size);
+      Serial.printf("FIRMWARE: v%d, %u bytes, hash %08x\n", version, size, hash);
+      resume();
+    }
+
+    void update(std::list<uint32_t> nodes)
+    {
+      uint32_t now = millis();
+
+      // Status / offer
+      uint32_t period = targetHash ? FW_STATUS_MS + FW_STATUS_NODE * nodes.size() : FW_OFFER_MS;
+      if (now - statusAt >= period) {
+        statusAt = now;
+        transport.sendAll( status() );
+      }
+      if (!targetHash) return;
+
+      // Fleet complete => boot staged image
+      if (complete) {
+        if (!switchAt && fleetComplete(nodes)) {
+          switchAt = now + FW_SWITCH_MS;
+          LOGF("FIRMWARE: fleet complete, booting v%d\n", targetVersion);
+        }
+        if (switchAt && (int32_t)(now - switchAt) >= 0) {
+          if (esp_ota_set_boot_partition(staging) == ESP_OK) ESP.restart();
+          LOG("FIRMWARE: boot partition rejected");
+          reset();
+        }
+        return;
+      }
+
+      // Requests: expired ones freed, free slots refilled
+      for (int k=0; k<FW_INFLIGHT; k++)
+        if (inflight[k].chunk >= 0 && now - inflight[k].at > timeout) {
+          inflight[k].chunk = -1;
+          timeouts++;
+        }
+      for (int k=0; k<FW_INFLIGHT; k++)
+        if (inflight[k].chunk < 0) request(inflight[k], now);
+    }
+
+    // FH= / FR= / FD= payloads, true if msg was mine
+    bool receive(uint32_t from, String& msg)
+    {
+      if (msg.startsWith("FH=")) receiveStatus(from, msg.substring(3));
+      else if (msg.startsWith("FR=")) receiveRequest(from, msg.substring(3));
+      else if (msg.startsWith("FD=")) receiveChunk(msg.substring(3));
+      else return false;
+      return true;
+    }
+
+    void log() {
+      if (!targetHash) return;
+      Serial.printf("FIRMWARE: v%d %d/%d chunks, %u requests, %u timeouts (rtt %u ms), %u rejected, %u served\n",
+                      targetVersion, have, chunks, requests, timeouts, rtt, rejected, served);
+    }
+
+  private:
+    const esp_partition_t* running = nullptr;
+    const esp_partition_t* staging = nullptr;
+    uint8_t bitmap[FW_BITMAP];
+    FirmwareNode fleet[FW_NODES];
+    FirmwarePeer peers[FW_PEERS];
+    uint32_t statusAt = 0;
+    int saved = 0;
+
+    struct Request { int chunk = -1; uint32_t at = 0; };
+    Request inflight[FW_INFLIGHT];
+    Request asked[FW_ASKED];
+    int askedNext = 0;
+
+    static bool bit(const uint8_t* map, int i) { return map[i >> 3] & (1 << (i & 7)); }
+
+    int chunkSize(int c) {
+      return min((uint32_t)FW_CHUNK, targetSize - c * FW_CHUNK);
+    }
+
+    String status() {
+      if (!targetHash)
+        return "FH="+String(version)+","+String(size)+","+String(hash, HEX)+","+String((size + FW_CHUNK-1) / FW_CHUNK)+",*";
+      return "FH="+String(targetVersion)+","+String(targetSize)+","+String(targetHash, HEX)+","+String(have)+","
+                  +(complete ? String("*") : base64(bitmap, (chunks+7) / 8));
+    }
+
+    // Newer image => stage it, any node => remember what it has
+    void receiveStatus(uint32_t from, String msg)
+    {
+      String v[5];
+      for (int k=0; k<5; k++) {
+        int pos = msg.indexOf(",");
+        if (pos == -1) pos = msg.length();
+        v[k] = msg.substring(0, pos);
+        msg = msg.substring(pos+1);
+      }
+      int peerVersion = v[0].toInt();
+      uint32_t peerSize = strtoul(v[1].c_str(), NULL, 10);
+      uint32_t peerHash = strtoul(v[2].c_str(), NULL, 16);
+
+      FirmwareNode& n = fleetNode(from);
+      n.silent = (peerVersion == 0);
+      n.hash = peerHash;
+      n.all = (v[4] == "*");
+      if (n.silent) return;
+
+      if (peerVersion > version && peerVersion > targetVersion && staging
+          && peerSize <= staging->size && peerSize <= FW_MAX_CHUNKS * FW_CHUNK)
+        start(peerVersion, peerSize, peerHash);
+
+      FirmwarePeer& p = peer(from);
+      p.hash = peerHash;
+      p.have = v[3].toInt();
+      p.all = (v[4] == "*");
+      if (!p.all) {
+        memset(p.bitmap, 0, FW_BITMAP);
+        unbase64(v[4], p.bitmap, FW_BITMAP);
+      }
+    }
+
+    // Serve a chunk of the running or staged image
+    void receiveRequest(uint32_t from, String msg)
+    {
+      int pos = msg.indexOf(",");
+      uint32_t h = strtoul(msg.substring(0, pos).c_str(), NULL, 16);
+      int c = msg.substring(pos+1).toInt();
+
+      const esp_partition_t* part = nullptr;
+      uint32_t length = 0;
+      if (h == hash) { part = running; length = size; }
+      else if (h == targetHash && c < chunks && bit(bitmap, c)) { part = staging; length = targetSize; }
+      if (!part || c < 0 || (uint32_t)c * FW_CHUNK >= length) return;
+
+      uint8_t data[FW_CHUNK];
+      int n = min((uint32_t)FW_CHUNK, length - c * FW_CHUNK);
+      if (esp_partition_read(part, c * FW_CHUNK, data, n) != ESP_OK) return;
+      transport.sendTo(from, "FD="+String(h, HEX)+","+String(c)+","+String(fnv(data, n, FNV_INIT), HEX)+","+base64(data, n));
+      served++;
+    }
+
+    // Store a chunk: checked, written in place
+    void receiveChunk(String msg)
+    {
+      int p1 = msg.indexOf(",");
+      int p2 = msg.indexOf(",", p1+1);
+      int p3 = msg.indexOf(",", p2+1);
+      if (p1 < 0 || p2 < 0 || p3 < 0) return;
+      if (strtoul(msg.substring(0, p1).c_str(), NULL, 16) != targetHash || complete) return;
+      int c = msg.substring(p1+1, p2).toInt();
+      if (c < 0 || c >= chunks || bit(bitmap, c)) return;
+
+      for (int k=0; k<FW_INFLIGHT; k++)
+        if (inflight[k].chunk == c) inflight[k].chunk = -1;
+
+      // Round trip (timed out requests too: their answers tell congestion)
+      for (int k=0; k<FW_ASKED; k++)
+        if (asked[k].chunk == c) {
+          uint32_t sample = millis() - asked[k].at;
+          rtt = rtt ? (rtt * 7 + sample) / 8 : sample;
+          timeout = constrain(2 * rtt, (uint32_t)FW_TIMEOUT_MS, (uint32_t)FW_TIMEOUT_MAX);
+          asked[k].chunk = -1;
+        }
+
+      uint8_t data[FW_CHUNK];
+      int n = unbase64(msg.substring(p3+1), data, FW_CHUNK);
+      if (n != chunkSize(c) || fnv(data, n, FNV_INIT) != strtoul(msg.substring(p2+1, p3).c_str(), NULL, 16)) {
+        rejected++;
+        return;
+      }
+
+      // First chunk of its sector => erase sector
+      int perSector = FW_SECTOR / FW_CHUNK;
+      int first = c / perSector * perSector;
+      bool erased = false;
+      for (int k=first; k<first+perSector && k<chunks; k++) erased |= bit(bitmap, k);
+      if (!erased && esp_partition_erase_range(staging, first * FW_CHUNK, FW_SECTOR) != ESP_OK) return;
+      if (esp_partition_write(staging, c * FW_CHUNK, data, n) != ESP_OK) return;
+
+      bitmap[c >> 3] |= 1 << (c & 7);
+      have++;
+      if (have - saved >= FW_SAVE_CHUNKS) save();
+
+      // Last one => check whole image
+      if (have == chunks) {
+        if (imageHash(staging, targetSize) == targetHash) {
+          complete = true;
+          save();
+          LOGF("FIRMWARE: v%d staged\n", targetVersion);
+        }
+        else {
+          LOG("FIRMWARE: image hash error, restart staging");
+          start(targetVersion, targetSize, targetHash);
+        }
+        statusAt = 0;
+      }
+    }
+
+    // Missing chunk, not requested yet, from a node that has it (both picked at random)
+    void request(Request& r, uint32_t now)
+    {
+      int from = random(chunks);
+      for (int i=0; i<chunks; i++)
+      {
+        int c = (from + i) % chunks;
+        if (bit(bitmap, c)) continue;
+        bool pending = false;
+        for (int k=0; k<FW_INFLIGHT; k++) pending |= (inflight[k].chunk == c);
+        if (pending) continue;
+
+        int start = random(FW_PEERS);
+        for (int j=0; j<FW_PEERS; j++) {
+          FirmwarePeer& p = peers[(start + j) % FW_PEERS];
+          if (!p.node || p.hash != targetHash || now - p.seenAt > FW_OFFER_MS + FW_STATUS_MS) continue;
+          if (!p.all && !bit(p.bitmap, c)) continue;
+          transport.sendTo(p.node, "FR="+String(targetHash, HEX)+","+String(c));
+          r.chunk = c;
+          r.at = now;
+          asked[askedNext] = r;
+          askedNext = (askedNext + 1) % FW_ASKED;
+          requests++;
+          return;
+        }
+      }
+    }
+
+    // Every node reported the staged image complete, but the FH=0 ones (bridge)
+    bool fleetComplete(std::list<uint32_t> nodes) {
+      for (uint32_t node : nodes) {
+        bool done = false;
+        for (int k=0; k<FW_NODES; k++)
+          if (fleet[k].node == node) done = fleet[k].silent || (fleet[k].hash == targetHash && fleet[k].all);
+        if (!done) return false;
+      }
+      return true;
+    }
+
+    FirmwareNode& fleetNode(uint32_t node) {
+      int slot = 0;
+      for (int k=0; k<FW_NODES; k++) {
+        if (fleet[k].node == node) { fleet[k].seenAt = millis(); return fleet[k]; }
+        if ((int32_t)(fleet[k].seenAt - fleet[slot].seenAt) < 0) slot = k;
+      }
+      fleet[slot] = FirmwareNode();
+      fleet[slot].node = node;
+      fleet[slot].seenAt = millis();
+      return fleet[slot];
+    }
+
+    FirmwarePeer& peer(uint32_t node) {
+      int slot = 0;
+      for (int k=0; k<FW_PEERS; k++) {
+        if (peers[k].node == node) { peers[k].seenAt = millis(); return peers[k]; }
+        if ((int32_t)(peers[k].seenAt - peers[slot].seenAt) < 0) slot = k;
+      }
+      peers[slot].node = node;
+      peers[slot].seenAt = millis();
+      return peers[slot];
+    }
+
+    // Stage a new image from scratch
+    void start(int v, uint32_t s, uint32_t h)
+    {
+      targetVersion = v;
+      targetSize = s;
+      targetHash = h;
+      chunks = (s + FW_CHUNK-1) / FW_CHUNK;
+      memset(bitmap, 0, FW_BITMAP);
+      have = saved = 0;
+      complete = false;
+      switchAt = 0;
+      for (int k=0; k<FW_INFLIGHT; k++) inflight[k].chunk = -1;
+      save();
+      LOGF3("FIRMWARE: staging v%d, %u bytes, hash %08x\n", v, s, h);
+    }
+
+    void reset() {
+      targetHash = 0;
+      targetVersion = 0;
+      complete = false;
+      switchAt = 0;
+      save();
+    }
+
+    // Progress in flash
+    void save() {
+      Preferences prefs;
+      prefs.begin("firmware", false);
+      prefs.putUInt("version", targetVersion);
+      prefs.putUInt("size", targetSize);
+      prefs.putUInt("hash", targetHash);
+      prefs.putBytes("bitmap", bitmap, FW_BITMAP);
+      prefs.end();
+      saved = have;
+    }
+
+    void resume() {
+      Preferences prefs;
+      prefs.begin("firmware", true);
+      int v = prefs.getUInt("version", 0);
+      uint32_t s = prefs.getUInt("size", 0);
+      uint32_t h = prefs.getUInt("hash", 0);
+      bool stored = prefs.getBytes("bitmap", bitmap, FW_BITMAP) == FW_BITMAP;
+      prefs.end();
+      if (!stored || !h || v <= version || !staging || s > staging->size || s > FW_MAX_CHUNKS * FW_CHUNK) {
+        memset(bitmap, 0, FW_BITMAP);
+        return;
+      }
+
+      targetVersion = v;
+      targetSize = s;
+      targetHash = h;
+      chunks = (s + FW_CHUNK-1) / FW_CHUNK;
+      have = 0;
+      for (int c=0; c<chunks; c++) if (bit(bitmap, c)) have++;
+      saved = have;
+      complete = (have == chunks && imageHash(staging, targetSize) == targetHash);
+      LOGF3("FIRMWARE: resume v%d, %d/%d chunks\n", targetVersion, have, chunks);
+    }
+
+    // FNV-1a
+    static const uint32_t FNV_INIT = 2166136261u;
+
+    static uint32_t fnv(const uint8_t* data, int n, uint32_t h) {
+      for (int i=0; i<n; i++) h = (h ^ data[i]) * 16777619u;
+      return h;
+    }
+
+    static uint32_t imageHash(const esp_partition_t* part, uint32_t length) {
+      if (!part) return 0;
+      uint8_t block[FW_CHUNK];
+      uint32_t h = FNV_INIT;
+      for (uint32_t at=0; at<length; at+=FW_CHUNK) {
+        int n = min((uint32_t)FW_CHUNK, length - at);
+        if (esp_partition_read(part, at, block, n) != ESP_OK) return 0;
+        h = fnv(block, n, h);
+      }
+      return h;
+    }
+
+    // Base64 (mesh messages are text)
+    static String base64(const uint8_t* data, int n) {
+      static const char* abc = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      String out;
+      out.reserve((n+2) / 3 * 4);
+      for (int i=0; i<n; i+=3) {
+        uint32_t v = data[i] << 16 | (i+1 < n ? data[i+1] << 8 : 0) | (i+2 < n ? data[i+2] : 0);
+        out += abc[(v >> 18) & 63];
+        out += abc[(v >> 12) & 63];
+        out += (i+1 < n) ? abc[(v >> 6) & 63] : '=';
+        out += (i+2 < n) ? abc[v & 63] : '=';
+      }
+      return out;
+    }
+
+    static int unbase64(const String& in, uint8_t* out, int max) {
+      uint32_t v = 0;
+      int bits = 0, n = 0;
+      for (unsigned i=0; i<in.length(); i++) {
+        char c = in.charAt(i);
+        int d = (c >= 'A' && c <= 'Z') ? c-'A' : (c >= 'a' && c <= 'z') ? c-'a'+26 :
+                (c >= '0' && c <= '9') ? c-'0'+52 : (c == '+') ? 62 : (c == '/') ? 63 : -1;
+        if (d < 0) break;
+        v = (v << 6) | d;
+        bits += 6;
+        if (bits >= 8) {
+          bits -= 8;
+          if (n == max) return -1;
+          out[n++] = v >> bits;
+        }
+      }
+      return n;
+    }
+};
+
+FirmwareShare firmware;
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef frames_h
+#define frames_h
+
+#include <K32_light.h>
+#include <esp_partition.h>
+
+#ifdef CLOUD_HOST
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// FRAME SEQUENCE
+//   pre-rendered pixel frames read in place (memory-mapped flash partition or file),
+//   one row = one frame. Built with cloud/png2frames.
+//
+//   header (16 bytes, little endian):
+//     "CLDF"  version(u8)  channels(u8: 3 = RGB, 4 = RGBW)  flags(u8: 1 = RLE)  reserved(u8)
+//     pixels(u16)  fps(u16)  frames(u32)
+//   RLE only: frame offsets (u32 x frames), from start of data
+//   data: raw frames (pixels x channels bytes) or RLE runs: count(u8, 1-255) + pixel
+//   open() checks frames and RLE offsets against the mapped size, runs are read up to its end.
+//
+
+#define FRAMES_PARTITION  "frames"
+#define FRAMES_HEADER     16
+#define FRAMES_RLE        0x01
+
+class FrameSequence {
+  public:
+    const uint8_t* base = nullptr;
+    const uint8_t* data = nullptr;
+    const uint8_t* offsets = nullptr;
+    size_t length = 0;
+
+    int channels = 3;
+    bool rle = false;
+    int pixels = 0;
+    int fps = 0;
+    uint32_t frames = 0;
+
+    // Parse header of a sequence mapped at ptr
+    bool open(const uint8_t* ptr, size_t len)
+    {
+      base = nullptr;
+      if (!ptr || len < FRAMES_HEADER || memcmp(ptr, "CLDF", 4) != 0 || ptr[4] != 1) return false;
+
+      channels = ptr[5];
+      rle = ptr[6] & FRAMES_RLE;
+      pixels = ptr[8] | ptr[9] << 8;
+      fps = ptr[10] | ptr[11] << 8;
+      frames = u32(ptr + 12);
+      if ((channels != 3 && channels != 4) || pixels == 0 || fps == 0 || frames == 0) return false;
+
+      offsets = ptr + FRAMES_HEADER;
+      size_t room = len - FRAMES_HEADER;
+      if (rle) {
+        if (frames > room / 4) return false;
+        data = offsets + 4 * frames;
+        size_t runs = room - 4 * frames;
+        for (uint32_t f=0; f<frames; f++)
+          if (u32(offsets + 4 * f) >= runs) return false;
+      }
+      else {
+        data = offsets;
+        if ((uint64_t)frames * pixels * channels > room) return false;
+      }
+
+      base = ptr;
+      length = len;
+      return true;
+    }
+
+    // Map data partition (no copy in RAM)
+    bool openPartition(const char* label = FRAMES_PARTITION)
+    {
+      const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+      if (!part) return false;
+
+      const void* ptr;
+      spi_flash_mmap_handle_t handle;
+      if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) return false;
+
+      if (!open((const uint8_t*)ptr, part->size)) {
+        spi_flash_munmap(handle);
+        return false;
+      }
+      Serial.printf("FRAMES: %u frames of %d px @ %d fps%s\n", frames, pixels, fps, rle ? " (rle)" : "");
+      return true;
+    }
+
+  #ifdef CLOUD_HOST
+    // Map a sequence file (host build, png2frames output)
+    bool openFile(const char* path)
+    {
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      void* ptr = MAP_FAILED;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+        ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (ptr == MAP_FAILED) return false;
+
+      if (!open((const uint8_t*)ptr, st.st_size)) {
+        munmap(ptr, st.st_size);
+        return false;
+      }
+      Serial.printf("FRAMES: %s, %u frames of %d px @ %d fps%s\n", path, frames, pixels, fps, rle ? " (rle)" : "");
+      return true;
+    }
+  #endif
+
+    bool isOpen() {
+      return base != nullptr;
+    }
+
+    // Frame displayed at time (ms), looping
+    uint32_t frameAt(uint32_t time) {
+      return ((uint64_t)time * fps / 1000) % frames;
+    }
+
+    // Draw frame into out[size], nearest pixel when sizes differ
+    void row(uint32_t frame, CRGBW* out, int size)
+    {
+      if (!isOpen() || size <= 0) return;
+      frame %= frames;
+
+      // sample source pixel (j * pixels / size) for each output j, stepped without division
+      int step = pixels / size;
+      int stepRest = pixels % size;
+      int rest = 0;
+      int src = 0;
+
+      if (!rle) {
+        const uint8_t* p = data + (size_t)frame * pixels * channels;
+        for (int j=0; j<size; j++) {
+          out[j] = pixel(p + src * channels);
+          src += step;
+          rest += stepRest;
+          if (rest >= size) { src++; rest -= size; }
+        }
+        return;
+      }
+
+      // RLE: walk runs along with the output cursor
+      const uint8_t* p = data + u32(offsets + 4 * frame);
+      const uint8_t* end = base + length;
+      int runEnd = 0;
+      CRGBW color;
+      for (int j=0; j<size; j++) {
+        while (src >= runEnd && p + 1 + channels <= end) {
+          runEnd += p[0];
+          color = pixel(p + 1);
+          p += 1 + channels;
+        }
+        out[j] = color;
+        src += step;
+        rest += stepRest;
+        if (rest >= size) { src++; rest -= size; }
+      }
+    }
+
+  private:
+    inline CRGBW pixel(const uint8_t* p) {
+      return CRGBW{ p[0], p[1], p[2], (channels == 4) ? p[3] : 0 };
+    }
+
+    static uint32_t u32(const uint8_t* p) {
+      return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef golden_h
+#define golden_h
+
+// GOLDEN FRAMES (include after light.h)
+//   drives every macro and a DMX strip sweep through a fixed timeline (seeded random(),
+//   fixed data, show clock replaced by the timeline) and prints one hash per frame on serial:
+//     GOLDEN,<anim>,<case>,<frame>,<fnv1a>
+//     GOLDEN_PX,<anim>,<case>,<frame>,<rrggbbww...>     with GOLDEN_DUMP
+//   record a reference and diff later runs with cloud/golden.
+//   On the host: pio run -e golden -t exec (test/golden), reference in test/golden/reference.txt.gz
+//
+
+#define GOLDEN_SEED     1234
+#define GOLDEN_FRAMES   50
+#define GOLDEN_STEP     37        // ms between frames, not a divider of the durations
+// #define GOLDEN_DUMP             // pixels too (slow, but diff shows the changed pixels)
+
+const int goldenTuples[][2] = { {0, 1}, {1, 4}, {3, 4} };     // position, peers
+const int goldenMirrors[] = {0, 11, 41};                       // data[14]: none, 2 copies, 2 alternate
+
+uint32_t goldenNow = 0;
+uint32_t goldenClock() {
+  return goldenNow;
+}
+
+uint32_t goldenHash(const CRGBW* buf, int size)
+{
+  uint32_t h = 2166136261u;
+  for (int i=0; i<size; i++) {
+    h = (h ^ buf[i].r) * 16777619u;
+    h = (h ^ buf[i].g) * 16777619u;
+    h = (h ^ buf[i].b) * 16777619u;
+    h = (h ^ buf[i].w) * 16777619u;
+  }
+  return h;
+}
+
+void goldenFrame(String anim, int kase, int f, const CRGBW* buf, int size)
+{
+  Serial.printf("GOLDEN,%s,%d,%d,%08x\n", anim.c_str(), kase, f, goldenHash(buf, size));
+  #ifdef GOLDEN_DUMP
+    Serial.printf("GOLDEN_PX,%s,%d,%d,", anim.c_str(), kase, f);
+    for (int i=0; i<size; i++) Serial.printf("%02x%02x%02x%02x", buf[i].r, buf[i].g, buf[i].b, buf[i].w);
+    Serial.printf("\n");
+  #endif
+}
+
+// Macros: case = tuple index
+void goldenMacros(CRGBW* canvas)
+{
+  int frame[ANIM_DATA_SLOTS] = {0};
+
+  for (int n=0; n<macroCount; n++)
+    for (int t=0; t<3; t++)
+    {
+      randomSeed(GOLDEN_SEED + n);
+      anims[n]->init();
+      for (int f=0; f<GOLDEN_FRAMES; f++) {
+        macroFrame(n, 0, f * GOLDEN_STEP, goldenTuples[t][0], goldenTuples[t][1], frame);
+        anims[n]->render(frame, canvas, stripSIZE);
+        goldenFrame("macro_"+String(n), t, f, canvas, stripSIZE);
+      }
+    }
+}
+
+// DMX strip: case = data[5] * 100 + data[14], offset moving along frames
+void goldenDmx(Anim_dmx_strip* dmx, CRGBW* canvas)
+{
+  int data[ANIM_DATA_SLOTS] = {0};
+  data[0] = 255;                // master
+  data[1] = 255;                // red
+  data[2] = 80;                 // green
+  data[4] = 20;                 // white
+  data[6] = 60;                 // length
+  data[10] = 0;                 // background
+  data[12] = 40;
+  data[15] = 200;               // zoom
+
+  uint32_t (*clock)() = dmx->clock;
+  dmx->clock = goldenClock;
+  dmx->init();
+
+  for (int pix=0; pix<18; pix++)
+    for (int mirror : goldenMirrors)
+    {
+      data[5] = pix*10 + 1;
+      data[14] = mirror;
+      randomSeed(GOLDEN_SEED);
+      for (int f=0; f<GOLDEN_FRAMES; f++) {
+        goldenNow = f * GOLDEN_STEP;
+        data[7] = f * 5 % 256;
+        dmx->render(data, canvas);
+        goldenFrame("dmx", data[5]*100 + mirror, f, canvas, dmx->size());
+      }
+    }
+
+  dmx->clock = clock;
+}
+
+void goldenRun(Anim_dmx_strip* dmx)
+{
+  CRGBW* canvas = new CRGBW[max(stripSIZE, dmx->size())];
+  Serial.printf("GOLDEN: size %d, seed %d\n", stripSIZE, GOLDEN_SEED);
+  goldenMacros(canvas);
+  goldenDmx(dmx, canvas);
+  LOG("GOLDEN: done");
+  delete[] canvas;
+}
+
+#endif
@@ -4,23 +4,165 @@ K32_light* light = nullptr;
 #include <fixtures/K32_ledstrip.h>
 K32_fixture* strip = NULL;
 
+#include "anim_cloud.h"
+#include "arena.h"
+#include "outputs.h"
+#include "probe.h"
+
+// Render buffers: 2 fade buffers + DMX strip pattern & segment
+#define SCRATCH_BUFFERS 4
+ScratchArena* scratch = nullptr;
+
+/// OUTPUT LATENCY
+//   WS281x pixels latch all together once the whole frame went down the wire:
+//   a frame drawn at t lights up at t + wire time + latch. 
+//   Macros are rendered ahead by that time so that long and short strips light up in phase.
+#define LED_BIT_NS    1250    // 800 kHz
+#define LED_LATCH_US  280     // WS2812B V3 / WS2815 reset
+
+uint32_t renderAhead = 0;     // ms
+
+// Wire time of one frame in µs
+uint32_t stripWireTime(int pixels, int type) {
+  int bits = (type == LED_SK6812W_V1) ? 32 : 24;
+  return (uint32_t)pixels * bits * LED_BIT_NS / 1000 + LED_LATCH_US;
+}
+
+/// MACRO FADE
+#define MACRO_FADE_MS 600     // cross-fade duration between macros (0 = hard cut)
+
+// Draw outgoing and incoming macros into scratch buffers, 
+// blend them on strip in a single pass.
+//   data[0] = alpha (0 -> 256 = incoming only)
+//   data[1-6] = outgoing frame, data[7-12] = incoming frame
+//
+class Anim_macro_fade : public K32_anim {
+  public:
+    Anim_cloud* from = nullptr;
+    Anim_cloud* to = nullptr;
+    CRGBW* bufFrom = nullptr;
+    CRGBW* bufTo = nullptr;
+    Probe probe{"macro fade"};
+
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      if (!from || !to) return;
+      probe.begin();
+
+      int frame[ANIM_DATA_SLOTS] = {0};
+      for (int k=0; k<6; k++) frame[k] = data[1+k];
+      from->render(frame, bufFrom, size());
+      for (int k=0; k<6; k++) frame[k] = data[7+k];
+      to->render(frame, bufTo, size());
+
+      uint16_t alpha = data[0];
+      uint16_t beta = 256 - alpha;
+      for (int i=0; i<size(); i++) {
+        const CRGBW& a = bufFrom[i];
+        const CRGBW& b = bufTo[i];
+        put(i, CRGBW{ (a.r*beta + b.r*alpha) >> 8, 
+                      (a.g*beta + b.g*alpha) >> 8, 
+                      (a.b*beta + b.b*alpha) >> 8, 
+                      (a.w*beta + b.w*alpha) >> 8 } );
+      }
+
+      probe.end();
+    }
+
+    // Last incoming frame as is (alpha 256), the incoming macro takes over from it
+    void finish() {
+      if (!to) return;
+      for (int i=0; i<size(); i++) put(i, bufTo[i]);
+    }
+
+  private:
+    inline void put(int i, const CRGBW& color) {
+      if (outputs) outputs->pix(i, output.apply(color));
+      else this->pixel(i, output.apply(color));
+    }
+};
+
+Anim_macro_fade* fade = nullptr;
+
 /// ANIMATIONS & MACRO
 int stripSIZE = 0;
-K32_anim* anims[16] = {NULL};
+Anim_cloud* anims[16] = {NULL};
 int durations[16] = {0};
 int loopLoop[16] = {0};
-int macro = 0;
+int macro = 0;                // requested macro (shared with peers)
+int macroPlaying = -1;        // macro currently drawn on strip
+int macroArmed = -1;          // macro prepared ahead for the next switch
 int macroCount = 0;
 uint32_t macroTimeOffset = 0;
+uint32_t playingTimeOffset = 0;
+
+int fadeFrom = -1;            // outgoing macro while fading
+uint32_t fadeTimeOffset = 0;
+uint32_t fadeStart = 0;
 int macroChanged = false;
 
-void lightSetup(K32* k32, int stripSize, int stripType, int stripPin) {
+uint32_t macroRequestedAt = 0;      // µs, switch request -> applied on next frame
+Probe switchProbe("macro switch");
+
+// Max refresh rate by number of parallel outputs (wire time of one output)
+void outputsModel(int pixels, int type) {
+  for (int n=1; n<=OUTPUTS_MAX; n*=2)
+    LOGF2("LIGHT: %d outputs -> %u fps max\n", n, 1000000 / stripWireTime((pixels+n-1)/n, type));
+}
+
+// Anim on every output (the strip if single)
+K32_anim* drawToOutputs(K32_anim* anim) {
+  if (!outputs) return anim->drawTo(strip);
+  for (int k=0; k<outputs->count; k++) anim->drawTo(outputs->strips[k]);
+  return anim;
+}
+
+// Whole logical strip, whatever the outputs
+void stripClear() {
+  if (outputs) outputs->all(CRGBW());
+  else strip->clear();
+}
+
+void stripPix(int i, CRGBW color) {
+  if (outputs) outputs->pix(i, color);
+  else strip->pix(i, color);
+}
+
+// Logical strip of stripSize pixels split in equal parts over count pins (1 = single strip),
+// serpentine: odd outputs are fed from their far end
+void lightSetup(K32* k32, int stripSize, int stripType, const int* pins, int count, bool serpentine=false) {
   light = new K32_light(k32);
   light->loadprefs();
   
   stripSIZE = stripSize;
-  strip = new K32_ledstrip(0, stripPin, stripType, stripSIZE);    
-  light->addFixture( strip );
+  count = constrain(count, 1, OUTPUTS_MAX);
+  int length = (stripSIZE + count - 1) / count;
+
+  if (count == 1) {
+    strip = new K32_ledstrip(0, pins[0], stripType, stripSIZE);    
+    light->addFixture( strip );
+  }
+  else {
+    outputs = new StripMap;
+    for (int k=0; k<count; k++) {
+      int part = min(length, stripSIZE - k*length);
+      if (part <= 0) break;
+      K32_fixture* output = new K32_ledstrip(k, pins[k], stripType, part);
+      light->addFixture( output );
+      outputs->add(output, part, serpentine && (k % 2));
+    }
+    outputs->build();
+    strip = outputs->strips[0];
+  }
+
+  renderAhead = (stripWireTime(length, stripType) + 500) / 1000;
+  LOGF3("LIGHT: %d outputs x %d px, render ahead %u ms\n", count, length, renderAhead);
+  outputsModel(stripSIZE, stripType);
+
+  // RGBW strips: common part of RGB goes to the white led
+  output.whiteExtract(stripType == LED_SK6812W_V1);
+
+  scratch = new ScratchArena( SCRATCH_BUFFERS * (stripSIZE * sizeof(CRGBW) + alignof(CRGBW)) );
 
   // INIT TEST STRIPS
   // light->anim( "test", new Anim_test_strip, 10 )
@@ -29,20 +171,41 @@ void lightSetup(K32* k32, int stripSize, int stripType, int stripPin) {
   //     ->play()
   //     ->wait();
 
+  // Library anims are uniform: drawn at the longest output length on every output
+  int firstSize = outputs ? outputs->lengths[0] : stripSIZE;
+
   // INIT TEST STRIPS
-  light->anim( "flash", new Anim_flash, stripSIZE )
-      ->drawTo(strip)
+  drawToOutputs( light->anim( "flash", new Anim_flash, firstSize ) )
       ->push(1, 50)
       ->play()
       ->wait();
 
   // OFF ANIM
-  light->anim( "off", new Anim_off, stripSIZE )
-      ->drawTo(strip);
+  drawToOutputs( light->anim( "off", new Anim_off, firstSize ) );
+
+  // MACRO FADE
+  fade = new Anim_macro_fade;
+  fade->bufFrom = scratch->pixels(stripSIZE);
+  fade->bufTo = scratch->pixels(stripSIZE);
+  light->anim( "fade", fade, stripSIZE )
+      ->drawTo(strip)
+      ->master(255);
 
 }
 
-K32_anim* addMacro(K32_anim* anim, int duration, int loops=1) {
+void lightSetup(K32* k32, int stripSize, int stripType, int stripPin) {
+  lightSetup(k32, stripSize, stripType, &stripPin, 1);
+}
+
+// Place the strip in the virtual strip of all clouds
+void lightCanvas(int offset, int total) {
+  for (int i=0; i<macroCount; i++) {
+    anims[i]->globalOffset = offset;
+    anims[i]->globalSize = total;
+  }
+}
+
+K32_anim* addMacro(Anim_cloud* anim, int duration, int loops=1) {
   if (macroCount == 16) return NULL;
   light->anim( "cloud_"+String(macroCount), anim, stripSIZE )
       ->drawTo(strip)
@@ -53,7 +216,7 @@ K32_anim* addMacro(K32_anim* anim, int duration, int loops=1) {
   return anims[macroCount-1];
 }
 
-K32_anim* getMacro(int n) {
+Anim_cloud* getMacro(int n) {
   if (n>=macroCount || n<0) return NULL;
   return anims[n];
 }
@@ -63,7 +226,7 @@ int getDuration(int n) {
   return durations[n];
 }
 
-K32_anim* activeMacro() {
+Anim_cloud* activeMacro() {
   return getMacro(macro);
 }
 
@@ -75,31 +238,111 @@ int activeDuration() {
   return getDuration(macro);
 }
 
+int nextMacroNumber() {
+  if (macroCount == 0) return 0;
+  return (macro+1) % macroCount;
+}
+
+// Prepare macro n ahead of time: its first frame won't pay for init()
+void armMacro(int n) {
+  if (n == macroArmed || n == macroPlaying) return;
+  Anim_cloud* anim = getMacro(n);
+  if (!anim) return;
+  anim->arm();
+  macroArmed = n;
+}
+
+// Stop drawing macro (the requested one will be played again on next frame)
+void stopMacro() {
+  Anim_cloud* anim = getMacro(macroPlaying);
+  if (anim) anim->stop();
+  if (fadeFrom >= 0) fade->stop();
+  fadeFrom = -1;
+  macroPlaying = -1;
+}
+
+// Request macro n: the anims are swapped on next frame by swapMacro()
 void setActiveMacro(uint32_t now, int n=-1) {
   if (macro == n) return;
   if (n==-1) n = macro;
   if (n>=macroCount || n<0) return;
   macro = n;
-  for (int i=0; i<macroCount; i++) {
-    if (i==macro) light->anim("cloud_"+String(i))->play();
-    else light->anim("cloud_"+String(i))->stop();
-  }
   macroTimeOffset = now;
+  macroRequestedAt = micros();
   LOG("Macro: "+String(macro));
   macroChanged = true;
 }
 
+// Timeline cue: macro n from offset, prepared with seed (same random colors on every node).
+// The playing macro is stopped first, or a new seed would not run prepare() again.
+void cueMacro(uint32_t offset, int n, uint16_t seed) {
+  if (n == macroPlaying) stopMacro();
+  randomSeed(seed);
+  macroArmed = -1;
+  armMacro(n);
+
+  setActiveMacro(offset, n);
+  macroTimeOffset = offset;    // same macro again: restart it
+}
+
 void nextMacro(uint32_t now) {
   if (macroCount == 0) return;
-  setActiveMacro(now, (macro+1) % macroCount);
+  setActiveMacro(now, nextMacroNumber());
 }
 
-void updateMacro(uint32_t now, int position, int peers, int autoNext=0)
+// Frame boundary: swap playing anim with the requested one
+void swapMacro(uint32_t now) {
+  if (macroPlaying == macro) return;
+
+  Anim_cloud* from = getMacro(macroPlaying);
+  Anim_cloud* to = activeMacro();
+  if (!to) return;
+
+  if (from) from->stop();
+  
+  // Cross-fade from playing macro
+  if (from && MACRO_FADE_MS > 0) {
+    to->init();
+    fade->from = from;
+    fade->to = to;
+    fadeFrom = macroPlaying;
+    fadeTimeOffset = playingTimeOffset;
+    fadeStart = now;
+    fade->play();
+  }
+  // Hard cut
+  else {
+    if (fadeFrom >= 0) fade->stop();
+    fadeFrom = -1;
+    to->play();
+  }
+
+  macroPlaying = macro;
+  if (macroArmed == macro) macroArmed = -1;
+  if (macroRequestedAt) switchProbe.add(micros() - macroRequestedAt);
+  macroRequestedAt = 0;
+
+  // Prepare the one coming next
+  armMacro(nextMacroNumber());
+}
+
+// Fade is over: incoming macro draws on strip again, from its state and last frame
+// (no prepare(), no redraw of stateful anims: no jump at the end of the fade)
+void endFade() {
+  fade->stop();
+  fade->finish();
+  fadeFrom = -1;
+  activeMacro()->takeOver();
+  activeMacro()->play();
+}
+
+// Data frame of macro n started at offset
+void macroFrame(int n, uint32_t offset, uint32_t now, int position, int peers, int frame[6])
 {
-  uint32_t animNow = now - macroTimeOffset;
+  uint32_t animNow = now - offset;
 
   // ROUND / TURN - DURATION
-  int duration = activeDuration();
+  int duration = getDuration(n);
   uint32_t roundDuration = duration * peers;
 
   // ROUND & TURN - CALC
@@ -109,11 +352,52 @@ void updateMacro(uint32_t now, int position, int peers, int autoNext=0)
 
   //   LOG("=== Round: "+ String(round)+ " // Position: " + String(pool->position())+ " / Turn: " + String(turn) + " // Time: " + String(time) + " // Duration: " + String(duration) + " // Macro: " + String(activeMacro()->name()) );
 
-  // AUTO-NEXT 
-  if (autoNext && round >= loopLoop[macro]) nextMacro(now);
+  frame[0] = duration;
+  frame[1] = time;
+  frame[2] = round;
+  frame[3] = turn;
+  frame[4] = position;
+  frame[5] = peers;
+}
 
+void updateMacro(uint32_t now, int position, int peers, int autoNext=0)
+{
+  // Frame shown when the strip actually lights up
+  uint32_t showNow = now + renderAhead;
+
+  // AUTO-NEXT: once the shown frame is past the last loop, next macro starts at that boundary
+  // (same offset on every node, whatever its strip latency)
+  if (autoNext && activeDuration() > 0) {
+    uint32_t loopDuration = (uint32_t)activeDuration() * peers;
+    if ((showNow - macroTimeOffset) / loopDuration >= (uint32_t)loopLoop[macro])
+      nextMacro(macroTimeOffset + loopLoop[macro] * loopDuration);
+  }
+
+  // FRAME BOUNDARY -> apply requested macro
+  swapMacro(now);
+  
   K32_anim* anim = activeMacro();
-  if (anim) 
-    anim->push(duration, time, round, turn, position, peers );
-}
+  if (!anim) return;
 
+  int frame[6];
+  macroFrame(macro, macroTimeOffset, showNow, position, peers, frame);
+
+  // FADE -> blend outgoing / incoming frames
+  if (fadeFrom >= 0) 
+  {
+    uint32_t elapsed = now - fadeStart;
+    if (elapsed < MACRO_FADE_MS) {
+      int fadeFrame[13];
+      fadeFrame[0] = elapsed * 256 / MACRO_FADE_MS;
+      macroFrame(fadeFrom, fadeTimeOffset, showNow, position, peers, &fadeFrame[1]);
+      for (int k=0; k<6; k++) fadeFrame[7+k] = frame[k];
+      fade->push(fadeFrame, 13);
+      playingTimeOffset = macroTimeOffset;
+      return;
+    }
+    endFade();
+  }
+
+  anim->push(frame[0], frame[1], frame[2], frame[3], frame[4], frame[5]);
+  playingTimeOffset = macroTimeOffset;
+}
@@ -0,0 +1,21 @@
+#ifndef macros_h
+#define macros_h
+
+// MACROS (include after light.h and anim_cloudled.h)
+//   the show, in macro number order: shared by the firmware and the host programs (bench, golden)
+//
+void addMacros() 
+{
+  addMacro(new Anim_cloud_wind,    3000, 1);
+  addMacro(new Anim_cloud_sparkle, 100,  1);
+  addMacro(new Anim_cloud_breath,  6000, 1);
+  addMacro(new Anim_cloud_flash,   150,  5);
+  addMacro(new Anim_cloud_rainbow, 3000, 2);
+  addMacro(new Anim_cloud_sparkle, 100,  1);
+  addMacro(new Anim_cloud_crawler, 1000, 5);
+  addMacro(new Anim_cloud_sparkle, 6000, 1);
+  addMacro(new Anim_cloud_flow,    4000, 2);
+  addMacro(new Anim_cloud_sweep,   3000, 3);
+}
+
+#endif
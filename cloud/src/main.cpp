@@ -11,11 +11,29 @@ K32_buttons* buttons = nullptr;
 
 #include "light.h"
 #include "anim_cloudled.h"
-// #include "anim_dmx_strip.h"
+#include "macros.h"
+#include "anim_dmx_strip.h"
+Anim_dmx_strip* dmx = nullptr;
+
+#include "artnet.h"
+ArtnetInput* artnet = nullptr;
+
+#include "bench.h"
+#include "golden.h"
 
 #include "peer.h"
 PeersPool* pool;
 
+//// Simulated loss: % of received control messages dropped (transport stats with PROBE_LOG)
+// #define TRANSPORT_LOSS 20
+////
+
+#include "transport.h"
+#include "firmware.h"
+#include "timeline.h"
+#include "probe.h"
+Probe loopProbe("loop");
+
 #include "painlessMesh.h"
 painlessMesh  mesh;
 SimpleList<uint32_t> activesNodes;
@@ -28,11 +46,36 @@ Scheduler userScheduler; // to control your personal task
 #define   MESH_PREFIX     "CloudLED"
 #define   MESH_PASSWORD   "somethingSneaky!"
 
+#define   ARTNET_UNIVERSE   0
+#define   DMX_PATCHSIZE     16      // Anim_dmx_strip slots, patched at channel * DMX_PATCHSIZE
+
 //// Disable once flashed (EEPROM stored)
 // #define K32_SET_NODEID 3      // board unique id  
 // #define HW_REVISION 0     // 0 = DevC - 1 = Atom
 ////
 
+//// Log probes (ms period)
+// #define PROBE_LOG 10000
+////
+
+//// Render benchmark at boot (CSV on serial)
+// #define CLOUD_BENCH
+////
+
+//// Golden frames hashes at boot (cloud/golden record / diff)
+// #define CLOUD_GOLDEN
+////
+
+//// Mesh events capture (serial: "D" dumps, a dump block sent back is replayed, see cloud/capture)
+// #define MESH_CAPTURE
+////
+
+#ifdef MESH_CAPTURE
+  #include "capture.h"
+  CaptureRing capture;
+  CaptureRing* replayed = nullptr;
+#endif
+
 uint32_t lastMeshMillis = 0;
 uint32_t meshMillisOffset = 0;
 uint32_t switchWifiAt = 0;    
@@ -49,6 +92,10 @@ State state = MACRO;
 // meshMillis (handle mesh µS overflow) -> will overflow after ~50 days
 uint32_t meshMillis() 
 {
+  #ifdef MESH_CAPTURE
+    if (replayed && replayed->replaying) return replayed->replayMillis();
+  #endif
+
   uint32_t meshMillis = mesh.getNodeTime()/1000 + meshMillisOffset;
   // if (meshMillis < lastMeshMillis) { // ERROR when mesh sync clocks (might sync backward)
   //   meshMillisOffset = lastMeshMillis;
@@ -62,6 +109,37 @@ uint32_t meshMillis()
 ////////   INFO         ////////
 ////////////////////////////////
 
+// My channel, strip size and groups: C=<channel>:<pixels>:<groups>
+String channelInfo() 
+{
+  return "C="+String(k32->system->channel())+":"+String(stripSIZE)+":"+String(pool->ownerGroups(), HEX);
+}
+
+// Groups of this node, stored in flash (set with G=<nodeId>,<groups>)
+uint32_t loadGroups() 
+{
+  Preferences prefs;
+  prefs.begin("groups", true);
+  uint32_t groups = prefs.getUInt("mask", GROUPS_DEFAULT);
+  prefs.end();
+  return groups;
+}
+
+void saveGroups(uint32_t groups) 
+{
+  Preferences prefs;
+  prefs.begin("groups", false);
+  prefs.putUInt("mask", groups);
+  prefs.end();
+}
+
+// Address prefix of macro messages: none for the whole mesh, @<zone>: otherwise
+String zonePrefix() 
+{
+  if (pool->zone() == GROUPS_ALL) return "";
+  return "@"+String(pool->zone(), HEX)+":";
+}
+
 // Send Info 
 void sendInfo() 
 {
@@ -70,7 +148,7 @@ void sendInfo()
   if (pool->isSolo()) 
   {
     Serial.println("Solo... broadcast my channel !");
-    mesh.sendBroadcast( "C="+String(k32->system->channel()) );
+    transport.sendState( channelInfo() );
   }
 
   // Master situation => send channel list periodically
@@ -78,24 +156,27 @@ void sendInfo()
   if (pool->isMaster()) 
   {
     Serial.println("Master... broadcast channel list !");
-    mesh.sendBroadcast( "CL="+pool->toString() );
+    transport.sendState( "CL="+pool->toString() );
   }
 }
 
 // Send Macro
 void sendMacro(int forced = 0) 
 {
-  // Master situation => send macro
-  if (pool->isMaster()) {
-    if (state == MACRO) mesh.sendBroadcast( "M="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
-    else if (state == LOOP) mesh.sendBroadcast( "L="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
-    else if (state == OFF) mesh.sendBroadcast( "OFF" );
+  // Timeline playing => every node follows the cues on its own
+  if (timeline.playing) return;
+
+  // Master (of my zone) situation => send macro
+  if (pool->isZoneMaster()) {
+    if (state == MACRO) transport.sendState( zonePrefix()+"M="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
+    else if (state == LOOP) transport.sendState( zonePrefix()+"L="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
+    else if (state == OFF) transport.sendState( zonePrefix()+"OFF" );
   }
 
   // Btn pressed (forced) => inform Master
   else if (forced && pool->masterID() > 0) {
-    if (state == MACRO) mesh.sendSingle(pool->masterID(), "M="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
-    else if (state == LOOP) mesh.sendSingle(pool->masterID(), "L="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
+    if (state == MACRO) transport.sendTo(pool->masterID(), zonePrefix()+"M="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
+    else if (state == LOOP) transport.sendTo(pool->masterID(), zonePrefix()+"L="+String(activeMacroNumber())+String(",")+String(macroTimeOffset) );
   }
 }
 
@@ -106,33 +187,104 @@ void sendMacroAuto() {
 Task userLoopTask1( TASK_MILLISECOND * 9100 , TASK_FOREVER, &sendInfo );
 Task userLoopTask2( TASK_MILLISECOND * 5000 , TASK_FOREVER, &sendMacroAuto );
 
+// Firmware share: status, requests, fleet switch
+void firmwareUpdate() {
+  firmware.update(mesh.getNodeList());
+}
+
+Task firmwareTask( TASK_MILLISECOND * 100 , TASK_FOREVER, &firmwareUpdate );
+
 
 ////////////////////////////////
 ////////   MESH         ////////
 ////////////////////////////////
 
 
+// Mesh transport
+void meshBroadcast( String &msg, bool includeSelf )
+{
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_SEND, 0, msg);
+    if (replayed && replayed->replaying) return;    // replay: record only
+  #endif
+  mesh.sendBroadcast(msg, includeSelf);
+}
+
+void meshSingle( uint32_t to, String &msg )
+{
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_SEND, to, msg);
+    if (replayed && replayed->replaying) return;
+  #endif
+  mesh.sendSingle(to, msg);
+}
+
 // Needed for painless library
 void receivedCallback( uint32_t from, String &msg ) 
+{
+  #ifdef MESH_CAPTURE
+    if (replayed && replayed->replaying) return;    // replay: live mesh ignored
+    capture.record(CAPTURE_RECV, from, msg);
+  #endif
+  transport.receive(from, msg);
+}
+
+
+////////////////////////////////
+////////   PROTOCOL     ////////
+////////////////////////////////
+
+// Group address of the message being handled (GROUPS_ALL: plain message)
+uint32_t addressed = GROUPS_ALL;
+
+// Macro messages drive my zone: an addressed one sets it (if it holds my primary group,
+// the others don't count me), a plain one (whole mesh) is ignored while I play in a zone
+bool zoneFollow() 
+{
+  if (addressed == GROUPS_ALL && pool->zone() != GROUPS_ALL) return false;
+  if (!(PeersPool::primary(pool->ownerGroups()) & addressed)) return false;
+  pool->zone(addressed);
+  return true;
+}
+
+// Control messages, whatever the transport
+void handleMessage( uint32_t from, String &msg ) 
 {
   if (switchWifiAt > 1) return;  // We are toggling wifi, ignore mesh
+
+  // Firmware chunks (not logged)
+  if (firmware.receive(from, msg)) return;
   
   Serial.printf("-- Received from %u msg=%s\n", from, msg.c_str());
 
+  // Group addressed: @<groups>:<msg>, dropped if none of mine
+  if (msg.startsWith("@")) 
+  {
+    int pos = msg.indexOf(":");
+    if (pos == -1) return;
+    uint32_t groups = strtoul(msg.substring(1, pos).c_str(), NULL, 16);
+    if (!(groups & pool->ownerGroups())) return;
+
+    String inner = msg.substring(pos+1);
+    addressed = groups;
+    handleMessage(from, inner);
+    addressed = GROUPS_ALL;
+  }
+
   // Receive channels list from Remote
-  if (msg.startsWith("CL=")) 
+  else if (msg.startsWith("CL=")) 
   {
     // Parse remote pool list
     PeersPool* remotePool = new PeersPool(msg.substring(3), from);
 
     // I am missing from the list => inform remote
-    if (remotePool->getChannel(pool->ownerID()) != pool->ownerChannel()) 
+    if (remotePool->getChannel(pool->ownerID()) != pool->ownerChannel() || remotePool->getGroups(pool->ownerID()) != pool->ownerGroups()) 
     {
       LOGF3("%d %d %lu == ", remotePool->getChannel(pool->ownerID()), pool->ownerChannel(), pool->ownerID());
       Serial.println("Remote list doesnt know me => sending my channel");
-      mesh.sendSingle(from, "C="+String(k32->system->channel()));
+      transport.sendTo(from, channelInfo());
     
-      remotePool->addPeer(mesh.getNodeId(), k32->system->channel());
+      remotePool->addPeer(mesh.getNodeId(), k32->system->channel(), stripSIZE, pool->ownerGroups());
     }
 
     // If remote is indeed master, update my pool
@@ -149,16 +301,16 @@ void receivedCallback( uint32_t from, String &msg )
   {
     Serial.println("Received channel from remote");
     int channel = msg.substring(2).toInt();
-    pool->addPeer(from, channel);
+    pool->addPeer(from, channel, PeersPool::parsePixels(msg.substring(2)), PeersPool::parseGroups(msg.substring(2)));
 
     if (channel < k32->system->channel()) {
       Serial.println("Remote channel is lower => He should know me so he takes the lead");
-      mesh.sendSingle(from, "C="+String(k32->system->channel()));
+      transport.sendTo(from, channelInfo());
     }
   }
 
   // Receive macro from Master
-  else if (msg.startsWith("M=") && state != OFF) 
+  else if (msg.startsWith("M=") && state != OFF && !timeline.playing && zoneFollow()) 
   {
     Serial.println("Received macro from master");
     msg = msg.substring(2);
@@ -173,7 +325,7 @@ void receivedCallback( uint32_t from, String &msg )
   }
 
   // Receive macro LOOP from Master
-  else if (msg.startsWith("L=") && state != OFF) 
+  else if (msg.startsWith("L=") && state != OFF && !timeline.playing && zoneFollow()) 
   {
     Serial.println("Received macro LOOP from master");
     msg = msg.substring(2);
@@ -192,10 +344,62 @@ void receivedCallback( uint32_t from, String &msg )
   {
     Serial.println("Received WIFI");
     switchWifiAt = millis()+5000;
-    activeMacro()->stop();
+    stopMacro();
     light->anim("flash")->push(6, 50, 100)->play();
   }
 
+  // Groups update: G=<nodeId>,<groups>
+  else if (msg.startsWith("G=")) 
+  {
+    msg = msg.substring(2);
+    int pos = msg.indexOf(",");
+    uint32_t nodeId = strtoul(msg.substring(0, pos).c_str(), NULL, 10);
+    uint32_t groups = strtoul(msg.substring(pos+1).c_str(), NULL, 16);
+    if (nodeId == mesh.getNodeId() && groups > 0) {
+      saveGroups(groups);
+      pool->ownerGroups(groups);
+      transport.sendAll( channelInfo() );
+      LOGF("GROUPS: %x\n", groups);
+    }
+  }
+
+  // Spatial map update: SP=<nodeId>,<x>,<y>,<z>[,...]
+  else if (msg.startsWith("SP=")) 
+  {
+    msg = msg.substring(3);
+    int pos = msg.indexOf(",");
+    uint32_t nodeId = strtoul(msg.substring(0, pos).c_str(), NULL, 10);
+    if (nodeId == mesh.getNodeId() && spatial.parse(msg.substring(pos+1))) {
+      spatial.save();
+      spatial.build(stripSIZE);
+    }
+  }
+
+  // Show timeline: TL=<chunk> / TP=<start> / TS
+  else if (msg.startsWith("TL=")) 
+  {
+    timeline.chunk(msg.substring(3));
+  }
+
+  else if (msg.startsWith("TP=")) 
+  {
+    uint32_t start = strtoul(msg.substring(3).c_str(), NULL, 10);
+    state = MACRO;
+    if (timeline.play(start)) LOGF("TIMELINE: play, start %u\n", start);
+    else {
+      // Missing chunks: ask the sender, play once complete
+      LOGF2("TIMELINE: not ready, start %u armed, missing chunks %08x\n", start, timeline.missing());
+      std::list<uint32_t> sender = { from };
+      transport.sendCritical("TN=" + String(timeline.missingChecksum(), HEX) + "," + String(timeline.missing(), HEX), sender);
+    }
+  }
+
+  else if (msg.startsWith("TS")) 
+  {
+    timeline.stop();
+    LOG("TIMELINE: stop");
+  }
+
   else if (msg.startsWith("OFF")) 
   {
     state = OFF;
@@ -206,19 +410,78 @@ void receivedCallback( uint32_t from, String &msg )
   // Serial.printf("Pool position: %d // size: %d\n", pool->position(), pool->size());
 }
 
-void changedConnectionCallback() 
+void topologyChanged(std::list<uint32_t> nodes) 
 {
+  #ifdef MESH_CAPTURE
+    uint8_t ids[4*PEER_MAX];
+    int n = 0;
+    for (uint32_t id : nodes) {
+      if (n == PEER_MAX) break;
+      for (int k=0; k<4; k++) ids[4*n+k] = id >> (8*k);
+      n++;
+    }
+    capture.record(CAPTURE_TOPOLOGY, 0, nodes.size(), ids, 4*n);
+  #endif
+
   pool->ownerID(mesh.getNodeId());
   // Serial.printf("I am, ownerID = %lu %lu\n", pool->ownerID(), mesh.getNodeId());
-  Serial.printf("Changed connections, node count = %d \n", mesh.getNodeList().size());
-  pool->updatePeers(mesh.getNodeList());
+  Serial.printf("Changed connections, node count = %d \n", nodes.size());
+  pool->updatePeers(nodes);
   sendInfo();
   sendMacro();
 }
 
+void changedConnectionCallback() 
+{
+  #ifdef MESH_CAPTURE
+    if (replayed && replayed->replaying) return;
+  #endif
+  topologyChanged(mesh.getNodeList());
+}
+
 void nodeTimeAdjustedCallback(int32_t offset) {
     Serial.printf("Adjusted time %u. Offset = %d\n", mesh.getNodeTime(),offset);
+  #ifdef MESH_CAPTURE
+    capture.record(CAPTURE_TIME, 0, offset, nullptr, 0);
+  #endif
+}
+
+
+#ifdef MESH_CAPTURE
+// Captured events -> protocol, as if received from mesh
+void replayEvent(const CaptureEvent& ev, uint8_t* payload)
+{
+  if (ev.type == CAPTURE_RECV) {
+    String msg((char*)payload);
+    transport.receive(ev.node, msg);
+  }
+  else if (ev.type == CAPTURE_TOPOLOGY) {
+    std::list<uint32_t> nodes;
+    for (int k=0; k+4 <= ev.length; k+=4) 
+      nodes.push_back(payload[k] | payload[k+1] << 8 | payload[k+2] << 16 | (uint32_t)payload[k+3] << 24);
+    topologyChanged(nodes);
+  }
+}
+
+// Serial: "D" dumps the capture, "CAPTURE <bytes>" + hex lines loads a capture and replays it
+void captureSerial()
+{
+  if (!Serial.available()) return;
+  String line = Serial.readStringUntil('\n');
+  line.trim();
+
+  if (line == "D") capture.dump();
+  else if (line.startsWith("CAPTURE ")) {
+    if (!replayed) replayed = new CaptureRing;
+    if (replayed->load(line.substring(8).toInt())) {
+      capture.clear();
+      replayed->replayStart();
+      LOG("CAPTURE: replay start");
+    }
+    else LOG("CAPTURE: load failed");
+  }
 }
+#endif
 
 void switchToWifi() {
   light->anim("flash")->push(1, 1000, 100)->play()->wait();
@@ -278,7 +541,7 @@ void setup()
         state = MACRO;
         LOG("STATE: MACRO");
       }
-      activeMacro()->stop();
+      stopMacro();
       light->anim("flash")->push(1, 50, 100)->play()->wait();
       LOG("NEXT");
       nextMacro( meshMillis() );
@@ -308,7 +571,7 @@ void setup()
 
       // -> LOOP
       else if (state == MACRO || state == LOOP) {
-        activeMacro()->stop();
+        stopMacro();
         light->anim("flash")->push(1, 1500, 100)->play()->wait();
         state = LOOP;
         LOG("STATE: LOOP");
@@ -330,7 +593,7 @@ void setup()
         }
         else {
           switchWifiAt = 1;
-          mesh.sendBroadcast("WIFI", true);
+          transport.sendCritical("WIFI", mesh.getNodeList(), true);
         }
       }
 
@@ -341,7 +604,7 @@ void setup()
 
       // -> OFF
       else {
-        mesh.sendBroadcast("OFF", true);
+        transport.sendCritical("OFF", mesh.getNodeList(), true);
       }
     }
 
@@ -351,6 +614,24 @@ void setup()
   if (k32->system->hw() == 0) lightSetup(k32, 750, LED_WS2815_V1, 22);            // DevC
   else if (k32->system->hw() == 1) lightSetup(k32, 25, LED_WS2812B_V3, 27);       // Atom
 
+  // DevC with the 750 px split over parallel outputs:
+  // int pins[] = {22, 21, 19, 18};
+  // lightSetup(k32, 750, LED_WS2815_V1, pins, 4);
+
+  // SPATIAL MAP
+  spatial.load(k32->system->channel());
+  spatial.build(stripSIZE);
+
+  // DMX STRIP (Art-Net input in WIFI state)
+  dmx = new Anim_dmx_strip(scratch);
+  dmx->clock = meshMillis;      // mesh stopped in WIFI state: local time, blink phased on Art-Net frames
+
+  // Pre-rendered frames for DMX color SD modes
+  FrameSequence* frames = new FrameSequence;
+  if (frames->openPartition()) dmx->sequence = frames;
+  light->anim( "dmx", dmx, stripSIZE )
+      ->drawTo(strip);
+
   // START MESH
   // mesh.setDebugMsgTypes( ERROR | MESH_STATUS | CONNECTION | SYNC | COMMUNICATION | GENERAL | MSG_TYPES | REMOTE ); // all types on
   mesh.setDebugMsgTypes( ERROR | STARTUP );  // set before init() so that you can see startup messages
@@ -358,8 +639,17 @@ void setup()
 
   // POOL
   pool = new PeersPool(mesh.getNodeId(), k32->system->channel());
+  pool->ownerPixels(stripSIZE);
+  pool->ownerGroups(loadGroups());
   
   // SET MESH
+  #ifdef MESH_CAPTURE
+    capture.clock = meshMillis;
+  #endif
+  transport.broadcast = meshBroadcast;
+  transport.single = meshSingle;
+  transport.handler = handleMessage;
+  transport.begin(mesh.getNodeId());
   mesh.onReceive(&receivedCallback);
   mesh.onChangedConnections(&changedConnectionCallback);
   mesh.onNodeTimeAdjusted(&nodeTimeAdjustedCallback);
@@ -369,24 +659,45 @@ void setup()
   userLoopTask1.enable();
   userLoopTask2.enable();
 
+  // FIRMWARE SHARE
+  firmware.begin(CLOUD_VERSION);
+  userScheduler.addTask( firmwareTask );
+  firmwareTask.enable();
+
   int master = 255;
 
 
   // CREATE ANIMATIONS
-  addMacro(new Anim_cloud_wind,    3000, 1)->master(master);
-  addMacro(new Anim_cloud_sparkle, 100,  1)->master(master);
-  addMacro(new Anim_cloud_breath,  6000, 1)->master(master);
-  addMacro(new Anim_cloud_flash,   150,  5)->master(master);
-  addMacro(new Anim_cloud_rainbow, 3000, 2)->master(master);
-  addMacro(new Anim_cloud_sparkle, 100,  1)->master(master);
-  addMacro(new Anim_cloud_crawler, 1000, 5)->master(master);
-  addMacro(new Anim_cloud_sparkle, 6000, 1)->master(master);
+  addMacros();
+
+  // Macros master is applied by the output stage
+  output.master(master);
+
+  #ifdef CLOUD_BENCH
+    benchRun(&dmx, 1);
+  #endif
+
+  #ifdef CLOUD_GOLDEN
+    goldenRun(dmx);
+  #endif
 
 
   setActiveMacro( meshMillis() );
 
   // Serial.printf("I am, ownerID = %lu %lu\n", pool->ownerID(), mesh.getNodeId());
 
+  // Probes log
+  #ifdef PROBE_LOG
+    k32->timer->every(PROBE_LOG, []() { 
+      Serial.printf("LOOP: cpu %u%%\n", loopProbe.total / (PROBE_LOG * 10));
+      probesLog(); 
+      transport.log();
+      firmware.log();
+      scratch->log(); 
+      if (artnet) artnet->log();
+    });
+  #endif
+
   // Heap Memory log
   // k32->timer->every(1000, []() {
   //   static int lastheap = 0;
@@ -398,11 +709,34 @@ void setup()
 }
 
 
+// Timeline: apply the cue active at now, in phase with its absolute time
+void timelineUpdate(uint32_t now) 
+{
+  int32_t time = timeline.showTime(mesh.getNodeTime());
+  int c = timeline.cueAt(time);
+  if (c < 0) return;
+
+  // Macro start in mesh ms, from the show clock: re-anchored when the node time wraps
+  Cue& cue = timeline.cues[c];
+  uint32_t offset = now - (uint32_t)(time - (int32_t)cue.at);
+  if (c == timeline.current) {
+    int32_t drift = offset - macroTimeOffset;
+    if (drift > 1 || drift < -1) macroTimeOffset = offset;
+    return;
+  }
+  timeline.current = c;
+
+  if (cue.master) output.master(cue.master);
+
+  // Same seed on every node => same random colors in prepare()
+  cueMacro(offset, cue.macro, cue.seed);
+}
+
 ////////////////////////////////
 ////////   LOOP        /////////
 ////////////////////////////////
 
-void loop() 
+void loopCloud() 
 { 
   // GO TO WIFI
   if (switchWifiAt > 0 && state != WIFI) 
@@ -433,11 +767,29 @@ void loop()
     uint32_t now = meshMillis();
 
     // LOGF2("%d %d\n", pool->position(), pool->count());
+    lightCanvas(pool->canvasOffset(), pool->canvasSize());
+    if (timeline.playing) timelineUpdate(now);
     updateMacro(now, pool->position(), pool->count(), state == LOOP);    
   }
 
   else if (state == WIFI) 
   {
+    // ARTNET
+    if (!artnet && wifi && wifi->isConnected()) {
+      int address = (k32->system->channel() % (512/DMX_PATCHSIZE)) * DMX_PATCHSIZE;
+      artnet = new ArtnetInput(dmx, ARTNET_UNIVERSE, address, DMX_PATCHSIZE);
+      artnet->begin();
+      LOGF("ARTNET: listening, address %d\n", address);
+    }
+    if (artnet) artnet->update();
+    
+    if (artnet && artnet->isReceiving()) {
+      if (!dmx->isPlaying()) dmx->play();
+      else if (dmx->timeBased()) artnet->refresh();
+      return;
+    }
+    else if (dmx->isPlaying()) dmx->stop();
+
     uint32_t now = meshMillis();
 
     byte val = (now/12)%100 + 0;
@@ -452,17 +804,31 @@ void loop()
       color = CRGBW::Cyan;
     
     color %= val;
-    strip->clear();
-    for (int i=0; i<5; i++) strip->pix(i, color);
+    stripClear();
+    for (int i=0; i<5; i++) stripPix(i, color);
   }
   
   else if (state == OFF)
   {
     mesh.update();
-    activeMacro()->stop();
+    stopMacro();
     light->anim("off")->push(1)->play();
   }
 
 
 
 }
+
+// Timed: loop cpu load is logged with probes
+void loop() 
+{
+  #ifdef MESH_CAPTURE
+    captureSerial();
+    if (replayed) replayed->replay(replayEvent);
+  #endif
+
+  loopProbe.begin();
+  transport.update();
+  loopCloud();
+  loopProbe.end();
+}
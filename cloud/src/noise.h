@@ -0,0 +1,71 @@
+#ifndef noise_h
+#define noise_h
+
+#include <Arduino.h>
+
+// VALUE NOISE
+//   fixed-point 2D value noise: lattice values from a permutation table built once
+//   from a fixed seed (same field on every cloud), smoothstep fade from a table.
+//   Coordinates are 24.8 fixed point: 256 = one lattice cell.
+//
+//   at(x, y) is a few table reads and 3 lerps, no division, no float.
+//
+
+#define NOISE_SEED  0x434c4f55
+
+class ValueNoise {
+  public:
+    ValueNoise(uint32_t seed = NOISE_SEED)
+    {
+      for (int i=0; i<256; i++) perm[i] = i;
+
+      // Fisher-Yates with xorshift32, identical on all nodes
+      uint32_t s = seed;
+      for (int i=255; i>0; i--) {
+        s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+        int j = s % (i+1);
+        uint8_t t = perm[i]; perm[i] = perm[j]; perm[j] = t;
+      }
+      for (int i=0; i<256; i++) perm[256+i] = perm[i];
+
+      // smoothstep 3t² - 2t³
+      for (int i=0; i<256; i++) {
+        uint32_t t = i;
+        fade[i] = (3*t*t*256 - 2*t*t*t) >> 16;
+      }
+    }
+
+    // 0-255
+    inline uint8_t at(uint32_t x, uint32_t y)
+    {
+      uint8_t xi = x >> 8;
+      uint8_t yi = y >> 8;
+      uint8_t fx = fade[x & 0xFF];
+      uint8_t fy = fade[y & 0xFF];
+
+      const uint8_t* row0 = perm + perm[yi];
+      const uint8_t* row1 = perm + perm[(uint8_t)(yi+1)];
+      uint8_t xj = xi + 1;
+
+      uint8_t top = lerp(perm[row0[xi]], perm[row0[xj]], fx);
+      uint8_t bot = lerp(perm[row1[xi]], perm[row1[xj]], fx);
+      return lerp(top, bot, fy);
+    }
+
+    // Two octaves (second one at double frequency, half amplitude)
+    inline uint8_t fractal(uint32_t x, uint32_t y) {
+      return (2 * at(x, y) + at(2*x + 0x8000, 2*y + 0x8000)) / 3;
+    }
+
+  private:
+    uint8_t perm[512];
+    uint8_t fade[256];
+
+    static inline uint8_t lerp(uint8_t a, uint8_t b, uint8_t t) {
+      return a + (((int)b - a) * t >> 8);
+    }
+};
+
+ValueNoise noise;
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef output_h
+#define output_h
+
+#include <K32_light.h>
+
+// OUTPUT STAGE
+//   per-channel gamma through lookup tables (computed when gamma changes),
+//   then master as one multiply per channel, then RGB -> RGBW white extraction (RGBW strips).
+//   The master changes every frame under strobe / modulators: it is not baked in the tables.
+//
+
+#define OUTPUT_GAMMA  2.2f      // perceptual WS281x (1.0 = linear, tables skipped)
+
+struct OutputLUT {
+  uint8_t curve[4][256];        // gamma only
+  float gammas[4] = {0, 0, 0, 0};
+  uint8_t level = 255;
+  bool rgbw = false;
+  bool linear = false;          // all gammas 1.0: tables skipped
+
+  OutputLUT(float g = OUTPUT_GAMMA) {
+    gamma(g);
+  }
+
+  // Same gamma on all channels
+  void gamma(float g) {
+    for (int c=0; c<4; c++) gamma(c, g);
+  }
+
+  void gamma(int c, float g) {
+    if (g == gammas[c]) return;
+    gammas[c] = g;
+    for (int v=0; v<256; v++)
+      curve[c][v] = (g == 1.0f) ? v : (uint8_t)(255.0f * powf(v/255.0f, g) + 0.5f);
+    linear = (gammas[0] == 1.0f && gammas[1] == 1.0f && gammas[2] == 1.0f && gammas[3] == 1.0f);
+  }
+
+  void master(uint8_t m) {
+    level = m;
+  }
+
+  uint8_t master() {
+    return level;
+  }
+
+  // Extract common part of RGB into W channel (RGBW strips)
+  void whiteExtract(bool enable) {
+    rgbw = enable;
+  }
+
+  // v * level / 255, rounded, without division
+  inline uint8_t scale(uint8_t v) {
+    uint32_t t = v * level + 128;
+    return (t + (t >> 8)) >> 8;
+  }
+
+  inline CRGBW apply(const CRGBW& color) {
+    CRGBW c = color;
+    if (rgbw) {
+      uint8_t white = min(color.r, min(color.g, color.b));
+      c = CRGBW{ color.r-white, color.g-white, color.b-white, min(255, color.w+white) };
+    }
+    if (!linear) c = CRGBW{ curve[0][c.r], curve[1][c.g], curve[2][c.b], curve[3][c.w] };
+
+    if (level == 255) return c;
+    return CRGBW{ scale(c.r), scale(c.g), scale(c.b), scale(c.w) };
+  }
+};
+
+// Final stage of cloud anims
+OutputLUT output;
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef outputs_h
+#define outputs_h
+
+#include <K32_light.h>
+
+// PARALLEL OUTPUTS
+//   one logical strip split over several physical strips, one pin / RMT channel each,
+//   refreshed in parallel: wire time is the one of the longest output only.
+//   Anims keep drawing logical indexes, pix() sends them to (output, pixel)
+//   through tables built once at setup. An output can be reversed (strip fed from its far end).
+//
+
+#define OUTPUTS_MAX  8
+
+class StripMap {
+  public:
+    K32_fixture* strips[OUTPUTS_MAX];
+    int lengths[OUTPUTS_MAX];
+    bool reversed[OUTPUTS_MAX];
+    int count = 0;
+    int total = 0;
+
+    uint8_t* which = nullptr;     // logical pixel -> output
+    uint16_t* index = nullptr;    // logical pixel -> pixel on output
+
+    // Append output after the previous ones
+    void add(K32_fixture* strip, int length, bool reverse = false) {
+      if (count == OUTPUTS_MAX) return;
+      strips[count] = strip;
+      lengths[count] = length;
+      reversed[count] = reverse;
+      total += length;
+      count++;
+    }
+
+    void build()
+    {
+      free(which);
+      free(index);
+      which = (uint8_t*)malloc(total);
+      index = (uint16_t*)malloc(total * sizeof(uint16_t));
+      if (!which || !index) {
+        LOG("OUTPUTS: allocation failed");
+        total = 0;
+        return;
+      }
+
+      int i = 0;
+      for (int k=0; k<count; k++)
+        for (int p=0; p<lengths[k]; p++, i++) {
+          which[i] = k;
+          index[i] = reversed[k] ? lengths[k]-1-p : p;
+        }
+    }
+
+    int size() {
+      return total;
+    }
+
+    inline void pix(int i, CRGBW color) {
+      if (i < 0 || i >= total) return;
+      strips[which[i]]->pix(index[i], color);
+    }
+
+    void all(CRGBW color) {
+      for (int k=0; k<count; k++)
+        for (int p=0; p<lengths[k]; p++) strips[k]->pix(p, color);
+    }
+};
+
+// nullptr: single strip, anims draw on their fixture
+StripMap* outputs = nullptr;
+
+#endif
@@ -5,10 +5,17 @@
 #include <list>
 
 #define PEER_MAX 16
+#define PEER_CHANNELS 32     // channels ranked for positions / canvas, higher ones come after them
+
+// Groups: bitmask per node, one bit per group (32 groups)
+#define GROUPS_DEFAULT  0x1           // group 0, also for peers that don't tell
+#define GROUPS_ALL      0xFFFFFFFF    // zone = whole mesh
 
 struct Peer { // This structure is named "myDataType"
   uint32_t nodeId;
   int channel;
+  int pixels;     // strip size, 0 = unknown
+  uint32_t groups;
 };
 
 
@@ -41,11 +48,13 @@ class PeersPool  {
             if (pos2 == -1) continue;
             String nodeId = peer.substring(0, pos2);
             String channel = peer.substring(pos2+1);
+            int pixels = parsePixels(channel);
+            uint32_t groups = parseGroups(channel);
             
             unsigned long nID = strtoul(nodeId.c_str(), NULL, 10); ;
 
-            if (nID == _nodeId) _channel = channel.toInt();
-            else addPeer(nID, channel.toInt());
+            if (nID == _nodeId) { _channel = channel.toInt(); _pixels = pixels; _groups = groups; }
+            else addPeer(nID, channel.toInt(), pixels, groups);
           }
         }
 
@@ -54,15 +63,19 @@ class PeersPool  {
           for(int i=0; i<PEER_MAX; i++) {
             peers[i].nodeId = 0;
             peers[i].channel = -1;
+            peers[i].pixels = 0;
+            peers[i].groups = GROUPS_DEFAULT;
           }
           _dirty = true;
         }
 
-        void addPeer(uint32_t nodeId, int channel=-1) {
+        void addPeer(uint32_t nodeId, int channel=-1, int pixels=0, uint32_t groups=0) {
           // LOG("Add peer: "+String(nodeId)+"="+String(channel));
           for(int i=0; i<PEER_MAX; i++) {
             if (peers[i].nodeId == nodeId) {
               peers[i].channel = channel;
+              if (pixels > 0) peers[i].pixels = pixels;
+              if (groups > 0) peers[i].groups = groups;
               _dirty = true;
               return;
             }
@@ -71,17 +84,38 @@ class PeersPool  {
             if (peers[i].nodeId == 0) {
               peers[i].nodeId = nodeId;
               peers[i].channel = channel;
+              peers[i].pixels = pixels;
+              peers[i].groups = groups > 0 ? groups : GROUPS_DEFAULT;
               _dirty = true;
               return;
             }
           }
         }
 
+        // "channel:pixels" -> pixels (0 if not given)
+        static int parsePixels(String value) {
+          int pos = value.indexOf(":");
+          if (pos == -1) return 0;
+          return value.substring(pos+1).toInt();
+        }
+
+        // "channel:pixels:groups" -> groups (hex, default group if not given)
+        static uint32_t parseGroups(String value) {
+          int pos = value.indexOf(":");
+          if (pos == -1) return GROUPS_DEFAULT;
+          pos = value.indexOf(":", pos+1);
+          if (pos == -1) return GROUPS_DEFAULT;
+          uint32_t groups = strtoul(value.substring(pos+1).c_str(), NULL, 16);
+          return groups > 0 ? groups : GROUPS_DEFAULT;
+        }
+
         void removePeer(uint32_t nodeId) {
           for(int i=0; i<PEER_MAX; i++) {
             if (peers[i].nodeId == nodeId) {
               peers[i].nodeId = 0;
               peers[i].channel = -1;
+              peers[i].pixels = 0;
+              peers[i].groups = GROUPS_DEFAULT;
               _dirty = true;
               return;
             }
@@ -97,6 +131,16 @@ class PeersPool  {
           return -1;
         }
 
+        uint32_t getGroups(uint32_t nodeId) {
+          if (nodeId == _nodeId) return _groups;
+          for(int i=0; i<PEER_MAX; i++) {
+            if (peers[i].nodeId == nodeId) {
+              return peers[i].groups;
+            }
+          }
+          return 0;
+        }
+
 
         void updatePeers(std::list<uint32_t> nodes) 
         {
@@ -136,11 +180,11 @@ class PeersPool  {
         void import(PeersPool* pool) 
         {
           clear();
-          addPeer(pool->ownerID(), pool->ownerChannel()); // add pool owner as peer
+          addPeer(pool->ownerID(), pool->ownerChannel(), pool->ownerPixels(), pool->ownerGroups()); // add pool owner as peer
 
           for(int i=0; i<PEER_MAX; i++) {
             if (pool->peers[i].nodeId != 0 && pool->peers[i].nodeId != _nodeId) {
-              addPeer(pool->peers[i].nodeId, pool->peers[i].channel);
+              addPeer(pool->peers[i].nodeId, pool->peers[i].channel, pool->peers[i].pixels, pool->peers[i].groups);
             }
           }
         }
@@ -152,20 +196,60 @@ class PeersPool  {
           return _size;
         }
 
-        // Number of distinct active channels
+        // Number of distinct active channels (in zone)
         int count() 
         {
           calculate();
           return _distinctChannels;
         }
 
-        // Position of owner in the active channel list
+        // Position of owner in the active channel list (in zone)
         int position() 
         {
           calculate();
           return _chanPosition;
         }
 
+        // First pixel of owner in the virtual strip of all channels
+        int canvasOffset() 
+        {
+          calculate();
+          return _canvasOffset;
+        }
+
+        // Pixels of the virtual strip
+        int canvasSize() 
+        {
+          calculate();
+          return _canvasSize;
+        }
+
+        // Zone: peers whose primary group is in mask. Position, count, canvas and
+        // macro master are computed within the zone (GROUPS_ALL: whole mesh)
+        void zone(uint32_t mask) {
+          if (mask == _zone) return;
+          _zone = mask;
+          _dirty = true;
+        }
+
+        uint32_t zone() {
+          return _zone;
+        }
+
+        static bool ranked(int channel) {
+          return channel > -1 && channel < PEER_CHANNELS;
+        }
+
+        // Primary group (lowest bit): a node in several groups plays one zone only,
+        // it is placed and counted in the zones of this group
+        static uint32_t primary(uint32_t groups) {
+          return groups & (~groups + 1);
+        }
+
+        bool inZone(int i) {
+          return peers[i].nodeId != 0 && peers[i].channel > -1 && (primary(peers[i].groups) & _zone);
+        }
+
         void calculate() 
         {
           if (!_dirty) return;
@@ -176,20 +260,20 @@ class PeersPool  {
             if (peers[i].nodeId != 0 && peers[i].channel > -1) _size++;
         
           // Distinct channels
-          int channels[32] = {0};
-          if (_channel > -1) channels[_channel] = 1;
+          int channels[PEER_CHANNELS] = {0};
+          if (ranked(_channel)) channels[_channel] = 1;
 
           for(int i=0; i<PEER_MAX; i++)
-            if (peers[i].nodeId != 0 && peers[i].channel > -1)
+            if (inZone(i) && ranked(peers[i].channel))
               channels[peers[i].channel]++;
 
           _distinctChannels = 0;
-          for(int i=0; i<32; i++)
+          for(int i=0; i<PEER_CHANNELS; i++)
             if (channels[i] > 0) _distinctChannels++;
 
           // Chan Position
           _chanPosition = 0;
-          for(int i=0; i<_channel; i++)
+          for(int i=0; i<min(_channel, PEER_CHANNELS); i++)
             if (channels[i] > 0) _chanPosition++;
 
           // Peers position
@@ -199,6 +283,30 @@ class PeersPool  {
               if (peers[i].channel < _channel) _peerPosition++;
               else if (peers[i].channel == _channel && peers[i].nodeId < _nodeId) _peerPosition++;
 
+          // Peers position in zone
+          _zoneSize = 0;
+          _zonePosition = 0;
+          for(int i=0; i<PEER_MAX; i++)
+            if (inZone(i)) {
+              _zoneSize++;
+              if (peers[i].channel < _channel || (peers[i].channel == _channel && peers[i].nodeId < _nodeId)) _zonePosition++;
+            }
+
+          // Canvas: channels in order, each one spans its longest strip (unknown = same as mine)
+          int spans[PEER_CHANNELS] = {0};
+          if (ranked(_channel)) spans[_channel] = _pixels;
+
+          for(int i=0; i<PEER_MAX; i++)
+            if (inZone(i) && ranked(peers[i].channel))
+              spans[peers[i].channel] = max(spans[peers[i].channel], peers[i].pixels > 0 ? peers[i].pixels : _pixels);
+
+          _canvasOffset = 0;
+          _canvasSize = 0;
+          for(int i=0; i<PEER_CHANNELS; i++) {
+            if (i < _channel) _canvasOffset += spans[i];
+            _canvasSize += spans[i];
+          }
+
           _dirty = false;
         }
 
@@ -210,6 +318,12 @@ class PeersPool  {
           return !isSolo() && _peerPosition == 0;
         }
 
+        // Macro master of my zone (the master when zone is the whole mesh)
+        bool isZoneMaster() {
+          calculate();
+          return _zoneSize > 0 && _zonePosition == 0;
+        }
+
         uint32_t ownerID() {
           return _nodeId;
         }
@@ -218,12 +332,13 @@ class PeersPool  {
           _nodeId = id;
         }
 
+        // Master of my zone
         uint32_t masterID() {
           if (isSolo()) return 0;
           uint32_t mID = 0;
           int mchan = 0;
           for(int i=0; i<PEER_MAX; i++)
-            if (peers[i].channel >= 0) 
+            if (inZone(i)) 
               if (mID == 0 || peers[i].channel < mchan || (peers[i].channel == mchan && peers[i].nodeId < mID) ) {
                 mID = peers[i].nodeId;
                 mchan = peers[i].channel;
@@ -235,11 +350,29 @@ class PeersPool  {
           return _channel;
         }
 
+        int ownerPixels() {
+          return _pixels;
+        }
+
+        void ownerPixels(int pixels) {
+          _pixels = pixels;
+          _dirty = true;
+        }
+
+        uint32_t ownerGroups() {
+          return _groups;
+        }
+
+        void ownerGroups(uint32_t groups) {
+          _groups = groups > 0 ? groups : GROUPS_DEFAULT;
+          _dirty = true;
+        }
+
         String toString() {
-          String str = String(_nodeId) + "=" + String(_channel);
+          String str = String(_nodeId) + "=" + String(_channel) + ":" + String(_pixels) + ":" + String(_groups, HEX);
           for(int i=0; i<PEER_MAX; i++)
             if (peers[i].nodeId != 0 && peers[i].channel != -1)
-              str += "," + String(peers[i].nodeId) + "=" + String(peers[i].channel);
+              str += "," + String(peers[i].nodeId) + "=" + String(peers[i].channel) + ":" + String(peers[i].pixels) + ":" + String(peers[i].groups, HEX);
 
           return str;
         }
@@ -249,11 +382,18 @@ class PeersPool  {
       private:
         uint32_t _nodeId = 0;
         int _channel = -1;
+        int _pixels = 0;
+        uint32_t _groups = GROUPS_DEFAULT;
+        uint32_t _zone = GROUPS_ALL;
 
         int _size = 0;
         int _chanPosition = 0;
         int _peerPosition = 0;
+        int _zoneSize = 0;
+        int _zonePosition = 0;
         int _distinctChannels = 0;
+        int _canvasOffset = 0;
+        int _canvasSize = 0;
 
         bool _dirty = true;
        
@@ -0,0 +1,61 @@
+#ifndef probe_h
+#define probe_h
+
+#include <Arduino.h>
+
+// PROBE
+//   minimal timing counter (µs): count / average / peak since last reset
+//   every probe registers itself, probesLog() reports them all
+//
+struct Probe {
+  const char* name;
+  uint32_t count = 0;
+  uint32_t total = 0;
+  uint32_t peak = 0;
+  uint32_t last = 0;
+  uint32_t startedAt = 0;
+  Probe* next = nullptr;
+
+  Probe(const char* n) : name(n) {
+    next = first();
+    first() = this;
+  }
+
+  static Probe*& first() {
+    static Probe* head = nullptr;
+    return head;
+  }
+
+  void begin() { startedAt = micros(); }
+  void end() { add(micros() - startedAt); }
+
+  void add(uint32_t us) {
+    last = us;
+    total += us;
+    if (us > peak) peak = us;
+    count++;
+  }
+
+  uint32_t average() {
+    return count ? total / count : 0;
+  }
+
+  void reset() {
+    count = total = peak = 0;
+  }
+
+  void log() {
+    if (count == 0) return;
+    Serial.printf("PROBE %s: n=%u avg=%uus peak=%uus last=%uus\n", name, count, average(), peak, last);
+  }
+};
+
+// Log and reset all probes
+void probesLog() {
+  for (Probe* p = Probe::first(); p; p = p->next) {
+    p->log();
+    p->reset();
+  }
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef pulse_h
+#define pulse_h
+
+#include <Arduino.h>
+
+#define PULSE_MAX 4
+
+// MULTI-PULSE
+//   on/off state of a repeating pulse pattern, as a pure function of time:
+//   within each cycle, pulse k starts at offsets[k] and lasts width ms.
+//   No state is kept between calls: nodes sharing a clock stay in phase.
+//
+struct MultiPulse {
+  uint32_t offsets[PULSE_MAX] = {0};
+  int count = 0;
+  uint32_t cycle = 1;
+  uint32_t width = 0;
+  uint32_t phase = 0;
+
+  // Pulses separated by intervals[0..n-1] (the last one closes the cycle)
+  void pattern(const uint32_t* intervals, int n, uint32_t width, uint32_t phase = 0) {
+    count = min(n, PULSE_MAX);
+    cycle = 0;
+    for (int k=0; k<count; k++) {
+      offsets[k] = cycle;
+      cycle += intervals[k];
+    }
+    if (cycle == 0) cycle = 1;
+    this->width = width;
+    this->phase = phase;
+  }
+
+  bool on(uint32_t now) {
+    uint32_t t = (now - phase) % cycle;
+    for (int k=0; k<count; k++) 
+      if (t - offsets[k] < width) return true;
+    return false;
+  }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef spatial_h
+#define spatial_h
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// SPATIAL MAP
+//   node position in the room + strip shape (polyline relative to the node), in cm,
+//   room origin at its center. Stored in flash (Preferences "spatial"), updated over the mesh:
+//     SP=<nodeId>,<x>,<y>,<z>[,<x>,<y>,<z>...]    node position, then shape points (optional):
+//                                                 position only moves the node, its shape is kept
+//   Pixels are spread evenly along the shape, their coordinates and distance to the center
+//   are computed once into tables: anims sample spatial fields with lookups only.
+//   Without stored map: one row along x per channel (SPATIAL_SPACING apart on y), strip
+//   straight along x, centered on the node: strips of any length don't overlap.
+//
+
+#define SPATIAL_POINTS    8
+#define SPATIAL_ROOM      1600      // cm, extent of sweeps
+#define SPATIAL_SPACING   100       // cm between rows by channel (default map)
+#define SPATIAL_PITCH     1.667f    // cm between pixels (default shape, 60 px/m)
+
+struct SpatialShape {
+  int16_t node[3];
+  int16_t points[SPATIAL_POINTS][3];
+  uint8_t count;
+};
+
+class SpatialMap {
+  public:
+    SpatialShape shape;
+
+    // Per pixel tables
+    int16_t* x = nullptr;
+    int16_t* y = nullptr;
+    int16_t* z = nullptr;
+    uint16_t* radius = nullptr;
+    int size = 0;
+
+    // Stored map or default from channel
+    void load(int channel)
+    {
+      Preferences prefs;
+      prefs.begin("spatial", true);
+      bool stored = prefs.getBytes("map", &shape, sizeof(shape)) == sizeof(shape);
+      prefs.end();
+
+      if (!stored || shape.count > SPATIAL_POINTS) {
+        memset(&shape, 0, sizeof(shape));
+        shape.node[1] = (channel - 8) * SPATIAL_SPACING;
+      }
+    }
+
+    void save() {
+      Preferences prefs;
+      prefs.begin("spatial", false);
+      prefs.putBytes("map", &shape, sizeof(shape));
+      prefs.end();
+    }
+
+    // "x,y,z[,x,y,z...]" -> node position [+ shape, kept if not given]
+    bool parse(String values)
+    {
+      int v[3 * (SPATIAL_POINTS+1)];
+      int n = 0;
+      while (values.length() > 0 && n < 3 * (SPATIAL_POINTS+1)) {
+        int pos = values.indexOf(",");
+        if (pos == -1) pos = values.length();
+        v[n++] = values.substring(0, pos).toInt();
+        values = values.substring(pos+1);
+      }
+      if (n < 3 || n % 3 != 0) return false;
+
+      for (int c=0; c<3; c++) shape.node[c] = v[c];
+      if (n > 3) {
+        shape.count = n/3 - 1;
+        for (int p=0; p<shape.count; p++)
+          for (int c=0; c<3; c++) shape.points[p][c] = v[3 + 3*p + c];
+      }
+      return true;
+    }
+
+    // Pixel tables for a strip of pixels (float math here only)
+    void build(int pixels)
+    {
+      if (pixels != size) {
+        free(x); free(y); free(z); free(radius);
+        x = (int16_t*)malloc(pixels * sizeof(int16_t));
+        y = (int16_t*)malloc(pixels * sizeof(int16_t));
+        z = (int16_t*)malloc(pixels * sizeof(int16_t));
+        radius = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+        size = (x && y && z && radius) ? pixels : 0;
+        if (!size) { LOG("SPATIAL: allocation failed"); return; }
+      }
+
+      // Polyline (default: straight along x, centered on the node)
+      float line[SPATIAL_POINTS][3];
+      int count = shape.count;
+      if (count >= 2) {
+        for (int p=0; p<count; p++)
+          for (int c=0; c<3; c++) line[p][c] = shape.points[p][c];
+      }
+      else {
+        count = 2;
+        memset(line, 0, sizeof(line));
+        line[0][0] = -pixels * SPATIAL_PITCH / 2;
+        line[1][0] = pixels * SPATIAL_PITCH / 2;
+      }
+
+      float lengths[SPATIAL_POINTS];
+      float total = 0;
+      for (int p=1; p<count; p++) {
+        float dx = line[p][0]-line[p-1][0], dy = line[p][1]-line[p-1][1], dz = line[p][2]-line[p-1][2];
+        lengths[p] = sqrtf(dx*dx + dy*dy + dz*dz);
+        total += lengths[p];
+      }
+
+      int seg = 1;
+      float segStart = 0;
+      for (int i=0; i<pixels; i++)
+      {
+        float at = total * (i + 0.5f) / pixels;
+        while (seg < count-1 && at > segStart + lengths[seg]) segStart += lengths[seg++];
+        float t = (lengths[seg] > 0) ? (at - segStart) / lengths[seg] : 0;
+
+        float p[3];
+        for (int c=0; c<3; c++) p[c] = shape.node[c] + line[seg-1][c] + t * (line[seg][c] - line[seg-1][c]);
+        x[i] = lroundf(p[0]);
+        y[i] = lroundf(p[1]);
+        z[i] = lroundf(p[2]);
+        radius[i] = lroundf(sqrtf(p[0]*p[0] + p[1]*p[1]));
+      }
+      Serial.printf("SPATIAL: node %d,%d,%d, %d shape points\n", shape.node[0], shape.node[1], shape.node[2], shape.count);
+    }
+
+    String toString() {
+      String str = String(shape.node[0]) + "," + String(shape.node[1]) + "," + String(shape.node[2]);
+      for (int p=0; p<shape.count; p++)
+        str += "," + String(shape.points[p][0]) + "," + String(shape.points[p][1]) + "," + String(shape.points[p][2]);
+      return str;
+    }
+};
+
+SpatialMap spatial;
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef timeline_h
+#define timeline_h
+
+#include <Arduino.h>
+
+// SHOW TIMELINE
+//   cue list (macro, seed, master at absolute show times) sent once to every node, in chunks:
+//     TL=<chunk>/<chunks>,<cues>,<checksum>:<at>,<macro>,<seed>,<master>;...
+//   checksum is FNV-1a over the cues (at u32, macro u8, seed u16, master u8, little endian).
+//   Once complete and valid, the show runs on each node from the mesh clock:
+//     TP=<start>     play, show time = mesh time - start (seek: earlier start)
+//     TS             stop
+//   no control message is needed during playback. Built and sent by cloud/show.
+//   TP= before the last chunk arms the start: the node answers TN=<checksum>,<missing chunks mask>
+//   (the bridge resends them) and plays, in phase, once complete.
+//   The node time (µs, 32 bits) wraps every 71 min: start is taken modulo the wrap (within 35 min
+//   of now) and the show clock accumulates node time deltas, so a show runs across the wrap.
+//
+
+#define TIMELINE_MAX    128
+#define TIMELINE_CHUNK  16      // cues per TL= message
+
+struct Cue {
+  uint32_t at;        // ms from show start
+  uint8_t macro;
+  uint16_t seed;      // random seed for macro prepare (same colors on all nodes)
+  uint8_t master;     // 0 = unchanged
+};
+
+class Timeline {
+  public:
+    Cue cues[TIMELINE_MAX];
+    int count = 0;
+    uint32_t checksum = 0;
+    bool ready = false;
+
+    bool playing = false;
+    bool armed = false;       // TP= received before the timeline was complete
+    uint32_t start = 0;       // mesh ms
+    int current = -1;
+
+    // TL= payload (after "TL="), true when the timeline is complete
+    bool chunk(String msg)
+    {
+      int slash = msg.indexOf("/");
+      int comma = msg.indexOf(",");
+      int comma2 = msg.indexOf(",", comma+1);
+      int colon = msg.indexOf(":");
+      if (slash < 0 || comma < 0 || comma2 < 0 || colon < 0) return false;
+
+      int index = msg.substring(0, slash).toInt();
+      int chunks = msg.substring(slash+1, comma).toInt();
+      int total = msg.substring(comma+1, comma2).toInt();
+      uint32_t sum = strtoul(msg.substring(comma2+1, colon).c_str(), NULL, 16);
+      if (total > TIMELINE_MAX || chunks > 32 || index >= chunks) return false;
+
+      // New timeline
+      if (sum != pendingChecksum || total != pendingCount) {
+        pendingChecksum = sum;
+        pendingCount = total;
+        pendingChunks = chunks;
+        received = 0;
+      }
+
+      // Cues
+      String list = msg.substring(colon+1);
+      int i = index * TIMELINE_CHUNK;
+      while (list.length() > 0 && i < total) {
+        int end = list.indexOf(";");
+        if (end == -1) end = list.length();
+        parseCue(list.substring(0, end), pending[i++]);
+        list = list.substring(end+1);
+      }
+      received |= (1UL << index);
+
+      // Complete => check and swap
+      if (received != (pendingChunks >= 32 ? 0xFFFFFFFF : (1UL << pendingChunks) - 1)) return false;
+      if (hash(pending, pendingCount) != pendingChecksum) {
+        Serial.printf("TIMELINE: checksum error\n");
+        received = 0;
+        return false;
+      }
+      memcpy(cues, pending, sizeof(Cue) * pendingCount);
+      count = pendingCount;
+      checksum = pendingChecksum;
+      ready = true;
+      current = -1;
+      Serial.printf("TIMELINE: %d cues, checksum %08x\n", count, checksum);
+      if (armed) {
+        armed = false;
+        playing = true;
+        synced = false;
+        Serial.printf("TIMELINE: complete, play armed start %u\n", start);
+      }
+      return true;
+    }
+
+    // TP=: false if the timeline is not complete yet, the start is armed (see missing())
+    bool play(uint32_t showStart) {
+      start = showStart;
+      current = -1;
+      synced = false;
+      playing = ready;
+      armed = !ready;
+      return playing;
+    }
+
+    void stop() {
+      playing = false;
+      armed = false;
+    }
+
+    // Chunks not received yet of the timeline being sent (all if none seen)
+    uint32_t missing() {
+      if (!pendingChunks) return 0xFFFFFFFF;
+      uint32_t all = pendingChunks >= 32 ? 0xFFFFFFFF : (1UL << pendingChunks) - 1;
+      return all & ~received;
+    }
+    uint32_t missingChecksum() { return pendingChecksum; }
+
+    // Show time (ms) at node time nodeUs (µs, 32 bits, wraps): first call from start,
+    // then accumulated deltas (call it more often than every 35 min)
+    int32_t showTime(uint32_t nodeUs) {
+      if (!synced) showUs = (int32_t)(nodeUs - start * 1000u);
+      else showUs += (int32_t)(nodeUs - lastUs);
+      synced = true;
+      lastUs = nodeUs;
+      return (int32_t)(showUs / 1000);
+    }
+
+    // Index of the cue active at show time (-1 before the first one)
+    int cueAt(int32_t time) {
+      int c = -1;
+      while (c+1 < count && (int32_t)cues[c+1].at <= time) c++;
+      return c;
+    }
+
+    static uint32_t hash(const Cue* list, int n) {
+      uint32_t h = 2166136261u;
+      for (int i=0; i<n; i++) {
+        uint8_t b[8] = { (uint8_t)list[i].at, (uint8_t)(list[i].at >> 8), (uint8_t)(list[i].at >> 16), (uint8_t)(list[i].at >> 24),
+                         list[i].macro, (uint8_t)list[i].seed, (uint8_t)(list[i].seed >> 8), list[i].master };
+        for (int k=0; k<8; k++) h = (h ^ b[k]) * 16777619u;
+      }
+      return h;
+    }
+
+  private:
+    Cue pending[TIMELINE_MAX];
+    int pendingCount = 0;
+    int pendingChunks = 0;
+    uint32_t pendingChecksum = 0;
+    uint32_t received = 0;
+
+    bool synced = false;
+    int64_t showUs = 0;
+    uint32_t lastUs = 0;
+
+    // "at,macro,seed,master"
+    static void parseCue(String s, Cue& cue) {
+      int v[4] = {0, 0, 0, 0};
+      for (int k=0; k<4 && s.length() > 0; k++) {
+        int pos = s.indexOf(",");
+        if (pos == -1) pos = s.length();
+        v[k] = strtoul(s.substring(0, pos).c_str(), NULL, 10);
+        s = s.substring(pos+1);
+      }
+      cue.at = v[0];
+      cue.macro = v[1];
+      cue.seed = v[2];
+      cue.master = v[3];
+    }
+};
+
+Timeline timeline;
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef transport_h
+#define transport_h
+
+#include <Arduino.h>
+#include <list>
+
+// TRANSPORT
+//   control messages (C=, CL=, M=, L=, WIFI, OFF) go out through sendAll() / sendTo()
+//   and come in through receive() only: the protocol handler does not know the mesh.
+//   The mesh is the default transport, another one (UDP loopback node, serial bridge...)
+//   installs its own send hooks and feeds what it receives to receive().
+//   Message rates are counted here, whatever the transport.
+//
+//   Delivery classes:
+//     sendCritical()  !<seq>:<msg>   acked by each node (ACK=<seq>), resent to the missing ones
+//                                    only, a few times, duplicates dropped by sequence number
+//     sendState()     ~<seq>:<msg>   periodic state, never acked nor resent: a state older than
+//                                    the last one of the same kind received from the same sender
+//                                    is dropped (kind: C=, CL=, zone play state M=/L=/OFF, by zone)
+//     sendAll/To()    <msg>          as is (bridge, older firmwares)
+//   Sequence numbers are per sender, a jump back beyond the window is taken as a restart.
+//   A critical message to more nodes than TRANSPORT_NODES takes several pending slots.
+//   TRANSPORT_LOSS drops this % of received messages (loss simulation).
+//
+
+#define TRANSPORT_PENDING   16      // critical messages waiting for acks: a full timeline (8 TL= chunks), TP=, margin
+#define TRANSPORT_NODES     32      // acks tracked per pending slot (bit mask)
+#define TRANSPORT_SENDERS   16      // senders tracked for sequence numbers
+#define TRANSPORT_KINDS     6       // state kinds tracked per sender (C=, CL=, play state of a few zones)
+#define TRANSPORT_RETRY_MS  250
+#define TRANSPORT_RETRIES   5
+#define TRANSPORT_WINDOW    32      // duplicate window, in sequence numbers
+
+struct Transport {
+  void (*broadcast)(String& msg, bool includeSelf) = nullptr;
+  void (*single)(uint32_t to, String& msg) = nullptr;
+  void (*handler)(uint32_t from, String& msg) = nullptr;
+  uint32_t id = 0;      // my node id (includeSelf of critical messages)
+
+  // Sequence numbers start at random (a restarted node is not taken for a duplicate), seeded
+  // here in setup(): random() is not ready for global constructors
+  void begin(uint32_t nodeId) {
+    id = nodeId;
+    criticalSeq = random(0x10000);
+    stateSeq = random(0x10000);
+  }
+
+  uint32_t sent = 0;
+  uint32_t received = 0;
+  uint32_t bytesSent = 0;
+  uint32_t bytesReceived = 0;
+  uint32_t statsAt = 0;
+
+  // Delivery stats (since boot)
+  uint32_t critical = 0;      // critical messages sent
+  uint32_t expected = 0;      // node deliveries expected
+  uint32_t delivered = 0;     // node deliveries acked
+  uint32_t retries = 0;
+  uint32_t lost = 0;          // node deliveries given up
+  uint32_t duplicates = 0;
+  uint32_t stale = 0;         // states dropped, older than the last one
+  uint32_t dropped = 0;       // simulated loss
+
+  void sendAll(String msg, bool includeSelf = false) {
+    sent++;
+    bytesSent += msg.length();
+    if (broadcast) broadcast(msg, includeSelf);
+  }
+
+  void sendTo(uint32_t to, String msg) {
+    sent++;
+    bytesSent += msg.length();
+    if (single) single(to, msg);
+  }
+
+  // Broadcast, acked by each of nodes
+  void sendCritical(String msg, std::list<uint32_t> nodes, bool includeSelf = false)
+  {
+    uint16_t seq = criticalSeq++;
+    String wire = "!" + String(seq) + ":" + msg;
+
+    // Nodes by TRANSPORT_NODES, one pending slot each (same seq)
+    Pending* p = nullptr;
+    for (uint32_t node : nodes) {
+      if (node == id) continue;
+      if (!p || p->count == TRANSPORT_NODES) {
+        p = &slot();
+        p->msg = wire;
+        p->seq = seq;
+        p->count = 0;
+        p->acked = 0;
+        p->at = millis();
+        p->tries = 0;
+        p->active = true;
+      }
+      p->nodes[p->count++] = node;
+      expected++;
+    }
+
+    critical++;
+    sendAll(wire);
+    if (includeSelf && handler) handler(id, msg);
+  }
+
+  // Periodic state, last one of its kind wins
+  void sendState(String msg) {
+    sendAll("~" + String(stateSeq++) + ":" + msg);
+  }
+
+  void receive(uint32_t from, String& msg)
+  {
+    #ifdef TRANSPORT_LOSS
+      if (random(100) < TRANSPORT_LOSS) { dropped++; return; }
+    #endif
+
+    received++;
+    bytesReceived += msg.length();
+
+    // Ack of my critical message
+    if (msg.startsWith("ACK=")) {
+      ack(from, strtoul(msg.substring(4).c_str(), NULL, 10));
+      return;
+    }
+
+    // Critical: ack (again), handle once
+    if (msg.startsWith("!")) {
+      int pos = msg.indexOf(":");
+      if (pos == -1) return;
+      uint16_t seq = strtoul(msg.substring(1, pos).c_str(), NULL, 10);
+      sendTo(from, "ACK=" + String(seq));
+      Sender& s = sender(from);
+      if (!fresh(s.critical, s.window, s.hasCritical, seq)) { duplicates++; return; }
+      String inner = msg.substring(pos+1);
+      if (handler) handler(from, inner);
+      return;
+    }
+
+    // State: drop if older than the last one
+    if (msg.startsWith("~")) {
+      int pos = msg.indexOf(":");
+      if (pos == -1) return;
+      uint16_t seq = strtoul(msg.substring(1, pos).c_str(), NULL, 10);
+      String inner = msg.substring(pos+1);
+      if (!newerState(sender(from), inner, seq)) { stale++; return; }
+      if (handler) handler(from, inner);
+      return;
+    }
+
+    if (handler) handler(from, msg);
+  }
+
+  // Resend critical messages to nodes that didn't ack
+  void update()
+  {
+    uint32_t now = millis();
+    for (int k=0; k<TRANSPORT_PENDING; k++)
+    {
+      Pending& p = pending[k];
+      if (!p.active || now - p.at < TRANSPORT_RETRY_MS) continue;
+
+      if (p.tries == TRANSPORT_RETRIES) {
+        lost += p.count - acks(p);
+        p.active = false;
+        continue;
+      }
+      for (int n=0; n<p.count; n++)
+        if (!(p.acked & (1UL << n))) {
+          sendTo(p.nodes[n], p.msg);
+          retries++;
+        }
+      p.tries++;
+      p.at = now;
+    }
+  }
+
+  // Log rates since last call, delivery since boot
+  void log() {
+    uint32_t elapsed = max((uint32_t)1, millis() - statsAt);
+    Serial.printf("TRANSPORT: out %u msg/s %u B/s, in %u msg/s %u B/s\n",
+                    sent*1000/elapsed, bytesSent*1000/elapsed, received*1000/elapsed, bytesReceived*1000/elapsed);
+    if (critical)
+      Serial.printf("TRANSPORT: critical %u, delivered %u/%u, %u retries, %u lost, %u duplicates, %u stale states\n",
+                    critical, delivered, expected, retries, lost, duplicates, stale);
+    sent = received = bytesSent = bytesReceived = 0;
+    statsAt = millis();
+  }
+
+  private:
+    struct Pending {
+      String msg;
+      uint16_t seq;
+      uint32_t nodes[TRANSPORT_NODES];
+      uint8_t count;
+      uint32_t acked;
+      uint32_t at;
+      uint8_t tries;
+      bool active = false;
+    };
+
+    struct Sender {
+      uint32_t node = 0;
+      uint16_t critical;
+      uint32_t window;      // critical seqs seen, bit k = critical-k
+      bool hasCritical = false;
+      uint32_t kinds[TRANSPORT_KINDS];
+      uint16_t states[TRANSPORT_KINDS];
+      uint8_t kindCount = 0;
+      uint8_t kindNext = 0;     // replaced when full
+      uint32_t seenAt = 0;
+    };
+
+    Pending pending[TRANSPORT_PENDING];
+    Sender senders[TRANSPORT_SENDERS];
+    uint16_t criticalSeq = 0;
+    uint16_t stateSeq = 0;
+
+    // Pending slot: free one or the oldest (its missing acks are lost)
+    Pending& slot() {
+      int slot = 0;
+      for (int k=0; k<TRANSPORT_PENDING; k++) {
+        if (!pending[k].active) { slot = k; break; }
+        if ((int32_t)(pending[k].at - pending[slot].at) < 0) slot = k;
+      }
+      Pending& p = pending[slot];
+      if (p.active) lost += p.count - acks(p);
+      return p;
+    }
+
+    int acks(Pending& p) {
+      int n = 0;
+      for (int k=0; k<p.count; k++) if (p.acked & (1UL << k)) n++;
+      return n;
+    }
+
+    void ack(uint32_t from, uint16_t seq) {
+      for (int k=0; k<TRANSPORT_PENDING; k++) {
+        Pending& p = pending[k];
+        if (!p.active || p.seq != seq) continue;
+        for (int n=0; n<p.count; n++)
+          if (p.nodes[n] == from && !(p.acked & (1UL << n))) {
+            p.acked |= (1UL << n);
+            delivered++;
+          }
+        if (acks(p) == p.count) p.active = false;
+      }
+    }
+
+    // Sender entry (least recently seen one is reused)
+    Sender& sender(uint32_t node) {
+      int slot = 0;
+      for (int k=0; k<TRANSPORT_SENDERS; k++) {
+        if (senders[k].node == node) { senders[k].seenAt = millis(); return senders[k]; }
+        if ((int32_t)(senders[k].seenAt - senders[slot].seenAt) < 0) slot = k;
+      }
+      senders[slot] = Sender();
+      senders[slot].node = node;
+      senders[slot].seenAt = millis();
+      return senders[slot];
+    }
+
+    // State kind: what a newer state replaces, zone included ("@<zone>:").
+    // M=, L= and OFF are one kind: the play state of the zone.
+    static uint32_t stateKind(const String& msg) {
+      int colon = msg.startsWith("@") ? msg.indexOf(":") + 1 : 0;
+      String body = msg.substring(colon);
+      String kind = msg.substring(0, colon);
+      int eq = body.indexOf("=");
+      if (body.startsWith("M=") || body.startsWith("L=") || body == "OFF") kind += "M";
+      else kind += (eq < 0) ? body : body.substring(0, eq);
+
+      uint32_t hash = 2166136261u;      // FNV-1a
+      for (unsigned int k=0; k<kind.length(); k++) hash = (hash ^ (uint8_t)kind[k]) * 16777619u;
+      return hash;
+    }
+
+    // seq newer than the last state of this kind from s, kind tracked from now if new
+    static bool newerState(Sender& s, const String& msg, uint16_t seq) {
+      uint32_t kind = stateKind(msg);
+      for (int k=0; k<s.kindCount; k++)
+        if (s.kinds[k] == kind) return newer(s.states[k], seq);
+
+      int k = s.kindCount;
+      if (k < TRANSPORT_KINDS) s.kindCount++;
+      else {
+        k = s.kindNext;
+        s.kindNext = (k + 1) % TRANSPORT_KINDS;
+      }
+      s.kinds[k] = kind;
+      s.states[k] = seq;
+      return true;
+    }
+
+    // seq newer than last (or not seen in the window), window updated
+    static bool fresh(uint16_t& last, uint32_t& window, bool& has, uint16_t seq) {
+      int16_t diff = seq - last;
+      if (!has || diff >= TRANSPORT_WINDOW || diff <= -TRANSPORT_WINDOW) {
+        has = true;
+        last = seq;
+        window = 1;
+        return true;
+      }
+      if (diff > 0) {
+        window = (window << diff) | 1;
+        last = seq;
+        return true;
+      }
+      uint32_t bit = 1UL << (-diff);
+      if (window & bit) return false;
+      window |= bit;
+      return true;
+    }
+
+    // seq newer than last (or far behind: sender restarted)
+    static bool newer(uint16_t& last, uint16_t seq) {
+      int16_t diff = seq - last;
+      if (diff <= 0 && diff > -TRANSPORT_WINDOW) return false;
+      last = seq;
+      return true;
+    }
+};
+
+Transport transport;
+
+#endif
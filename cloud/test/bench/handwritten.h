@@ -0,0 +1,228 @@
+#ifndef handwritten_h
+#define handwritten_h
+
+// HANDWRITTEN MACROS (include after compositor.h / anim_cloudled.h / bench.h)
+//   breath, crawler, rainbow and flash as they were before the compositor (per pixel writes),
+//   reference of the layer stack ports: same output (test_compositor), cost side by side (bench).
+//   wind as it was before the noise field (random() refill), cost side by side (bench).
+//
+
+class Anim_hand_breath : public Anim_cloud {
+  public:
+    CRGBW background;
+
+    void prepare() { this->background = colorPreset[random(0,N_COLOR)]; }
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      int duration = data[0];
+      int time    = data[1];
+
+      float progress = time*1.0f/duration;
+      byte breath = 70 + (0.5f + 0.5f * sin(2 * PI * progress)) * 185;
+
+      this->all( (CRGBW)(background%breath) );
+    }
+};
+
+class Anim_hand_crawler : public Anim_cloud {
+  public:
+    CRGBW background;
+
+    void prepare() { this->background = colorPreset[random(0,N_COLOR)]; }
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      int duration  = data[0];
+      int time      = data[1];
+      int turn      = data[3];
+      int position  = data[4];
+
+      float progress = time*1.0f/duration;
+
+      this->clear();
+
+      if (turn == position)
+      {
+        int crawlerSize = 10;
+
+        // CRAWLER
+        int pos = (int)(progress * this->size());
+        for (int i=pos; i>pos-crawlerSize; i--) {
+          if (i >= 0 && i < this->size()) {
+            this->pixel(i, CRGBW{255,255,255});
+          }
+        }
+
+        // BACKGROUND
+        for (int i=pos-crawlerSize; i>=0; i--)
+            this->pixel(i, this->background);
+      }
+      else if (turn > position)
+      {
+        int breath = (0.5f + 0.5f * cos(2 * PI * progress )) * 255;
+        this->all( (CRGBW) (this->background % (127+breath/2)) );
+      }
+      else
+      {
+        this->all( (CRGBW) (this->background % 50) );
+      }
+    }
+};
+
+class Anim_hand_rainbow : public Anim_cloud {
+  public:
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      int duration = data[0];
+      int time    = data[1];
+
+      int offset = this->size() * time / duration;
+
+      CRGBW colorWheel;
+      for(int i=0; i<this->size(); i++)
+        this->pixel(i, colorWheel.setHue( 255 * ((i+offset) % this->size()) / this->size() ) );
+    }
+};
+
+class Anim_hand_flash : public Anim_cloud {
+  public:
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      int duration = data[0];
+      int time    = data[1];
+      int turn    = data[3];
+      int position = data[4];
+
+      int offset = 100 * time / duration;
+
+      this->clear();
+
+      if (turn == position)
+      {
+        if (offset < 70) this->all( CRGBW::LightYellow );
+      }
+    }
+};
+
+class Anim_random_wind : public Anim_cloud {
+  public:
+    int lastTime = 0;
+    int nextTime = 0;
+
+    void draw (int data[ANIM_DATA_SLOTS])
+    {
+      int time    = data[1];
+      int count = data[5];
+
+      if (time < lastTime) nextTime = 0;
+      lastTime = time;
+
+      if (time > nextTime)
+      {
+        for (int i=0; i<this->size(); i++) {
+          byte rand = random(150, 250);
+          CRGBW color = (count > 1) ? CRGBW{0,rand,rand-50} : CRGBW{rand/3,rand,0};
+          this->pixel(i, color);
+        }
+        nextTime = time + random(30, 140);
+      }
+    }
+};
+
+// Layer stack port and handwritten version of the same macro
+struct HandPair {
+  const char* name;
+  Anim_cloud* ported;
+  Anim_cloud* hand;
+  int turn;           // data[3], position is 0
+};
+
+#define HAND_PAIRS 5
+
+HandPair* handPairs()
+{
+  static Anim_cloud_breath breath;
+  static Anim_cloud_crawler crawler;
+  static Anim_cloud_rainbow rainbow;
+  static Anim_cloud_flash flash;
+  static Anim_hand_breath handBreath;
+  static Anim_hand_crawler handCrawler;
+  static Anim_hand_rainbow handRainbow;
+  static Anim_hand_flash handFlash;
+
+  static HandPair pairs[HAND_PAIRS] = {
+    {"breath",        &breath,  &handBreath,  0},
+    {"crawler",       &crawler, &handCrawler, 0},     // background + crawler layers
+    {"crawler_after", &crawler, &handCrawler, 1},     // one dimmed layer
+    {"rainbow",       &rainbow, &handRainbow, 0},
+    {"flash",         &flash,   &handFlash,   0},
+  };
+  breath.background = handBreath.background = CRGBW{255, 120, 40, 10};
+  crawler.background = handCrawler.background = CRGBW{30, 200, 90, 0};
+  return pairs;
+}
+
+// Same frame for both versions: duration 3000, show time t, position 0
+void handFrame(int data[ANIM_DATA_SLOTS], int time, int turn) {
+  for (int k=0; k<ANIM_DATA_SLOTS; k++) data[k] = 0;
+  data[0] = 3000;
+  data[1] = time % 3000;
+  data[3] = turn;
+  data[5] = 2;
+}
+
+// BENCH,layers_<macro>,... against BENCH,hand_<macro>,... (param: turn)
+void benchHandwritten()
+{
+  HandPair* pairs = handPairs();
+  int data[ANIM_DATA_SLOTS];
+
+  for (int p=0; p<HAND_PAIRS; p++)
+    for (int size : benchSizes)
+      for (int version=0; version<2; version++)
+      {
+        Anim_cloud* anim = version ? pairs[p].hand : pairs[p].ported;
+        size_t mark = scratch->mark();
+        CRGBW* canvas = scratch->pixels(size);
+        if (!canvas) continue;
+
+        int heap = ESP.getFreeHeap();
+        uint32_t start = micros();
+        for (int f=0; f<BENCH_FRAMES; f++) {
+          handFrame(data, f * BENCH_STEP, pairs[p].turn);
+          anim->render(data, canvas, size);
+        }
+        benchLine(String(version ? "hand_" : "layers_") + pairs[p].name, size, pairs[p].turn, micros() - start, heap);
+
+        scratch->release(mark);
+      }
+}
+
+// BENCH,wind_noise,... against BENCH,wind_random,...: cost of a full refill (param: 1)
+void benchWind()
+{
+  static Anim_cloud_wind noise;
+  static Anim_random_wind refill;
+  int data[ANIM_DATA_SLOTS];
+
+  for (int size : benchSizes)
+    for (int version=0; version<2; version++)
+    {
+      Anim_cloud* anim = version ? (Anim_cloud*)&refill : (Anim_cloud*)&noise;
+      size_t mark = scratch->mark();
+      CRGBW* canvas = scratch->pixels(size);
+      if (!canvas) continue;
+
+      int heap = ESP.getFreeHeap();
+      uint32_t start = micros();
+      for (int f=0; f<BENCH_FRAMES; f++) {
+        handFrame(data, f * BENCH_STEP, 0);
+        refill.nextTime = 0;                  // refill on each frame, as the noise does
+        anim->render(data, canvas, size);
+      }
+      benchLine(version ? "wind_random" : "wind_noise", size, 1, micros() - start, heap);
+
+      scratch->release(mark);
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+// HOST BENCHMARK (pio run -e bench -t exec)
+//   the CLOUD_BENCH sweep of src/bench.h on Linux: every macro at 25 / 150 / 750 / 3000 pixels,
+//   the DMX strip pix modes at 150 / 750 / 3000 pixels,
+//   then the layer stack macros against their handwritten versions, the noise wind against
+//   the random() one (handwritten.h),
+//   then frame sequences (raw / RLE) read from a mapped file at 150 / 750 / 3000 pixels.
+//   CSV lines on stdout, same columns as on the board, heap used = bytes allocated by new:
+//     pio run -e bench -t exec | grep BENCH > bench.csv
+//
+
+#include <Arduino.h>
+#include <K32.h>
+#include <malloc.h>
+#include <new>
+
+#include "light.h"
+#include "anim_cloudled.h"
+#include "macros.h"
+#include "anim_dmx_strip.h"
+#include "bench.h"
+#include "handwritten.h"
+#include "sequence.h"
+
+// Allocations are counted as heap used
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t n) {
+  void* p = malloc(n);
+  if (!p) throw std::bad_alloc();
+  ESP.heapUsed += malloc_usable_size(p);
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  if (p) ESP.heapUsed -= malloc_usable_size(p);
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  operator delete(p);
+}
+
+const int dmxSizes[] = {150, 750, 3000};
+
+#define SEQUENCE_PIXELS 750
+#define SEQUENCE_FRAMES 100
+
+// Smooth gradient (raw) / flat bands (RLE), moving along frames
+CRGBW gradient(int frame, int pixel) { return CRGBW{ (pixel + frame) % 256, pixel * 255 / SEQUENCE_PIXELS, frame, 0 }; }
+CRGBW bands(int frame, int pixel) { return ((pixel + frame) / 50) % 2 ? CRGBW{255, 40, 0} : CRGBW{0, 0, 80}; }
+
+// Frame sequences mapped from file: BENCH,frames_<raw|rle>,<size>,<source pixels>,...
+void benchFrames()
+{
+  const char* kinds[] = {"raw", "rle"};
+  for (int k=0; k<2; k++)
+  {
+    String path = "/tmp/cloud_bench_" + String(kinds[k]) + ".cldf";
+    if (!sequenceSave(path.c_str(), sequenceEncode(SEQUENCE_PIXELS, SEQUENCE_FRAMES, 3, k, 25, k ? bands : gradient))) continue;
+
+    FrameSequence frames;
+    if (!frames.openFile(path.c_str())) continue;
+
+    for (int size : dmxSizes) {
+      size_t mark = scratch->mark();
+      CRGBW* canvas = scratch->pixels(size);
+      int heap = ESP.getFreeHeap();
+      uint32_t start = micros();
+      for (int f=0; f<BENCH_FRAMES; f++) frames.row(f, canvas, size);
+      benchLine("frames_" + String(kinds[k]), size, SEQUENCE_PIXELS, micros() - start, heap);
+      scratch->release(mark);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  K32* k32 = new K32();
+  lightSetup(k32, 3000, LED_WS2815_V1, 22);
+  addMacros();
+  output.master(255);
+  spatial.load(k32->system->channel());     // sweep: pixel tables of the longest strip, as setup() does
+  spatial.build(3000);
+
+  Anim_dmx_strip* dmx[3];
+  for (int k=0; k<3; k++) {
+    dmx[k] = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(dmxSizes[k])) );
+    light->anim( "dmx_"+String(dmxSizes[k]), dmx[k], dmxSizes[k] )
+        ->drawTo(strip);
+  }
+
+  benchRun(dmx, 3);
+  benchHandwritten();
+  benchWind();
+  benchFrames();
+  return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef sequence_h
+#define sequence_h
+
+// CLDF WRITER (host): frame sequences for the frames bench and tests,
+//   same encoding as png2frames (src/frames.h for the format).
+//
+
+#include <vector>
+
+typedef CRGBW (*SequenceColor)(int frame, int pixel);
+
+void sequencePut16(std::vector<uint8_t>& out, uint32_t v) { out.push_back(v); out.push_back(v >> 8); }
+void sequencePut32(std::vector<uint8_t>& out, uint32_t v) { sequencePut16(out, v); sequencePut16(out, v >> 16); }
+
+void sequencePixel(std::vector<uint8_t>& out, CRGBW c, int channels) {
+  out.push_back(c.r);
+  out.push_back(c.g);
+  out.push_back(c.b);
+  if (channels == 4) out.push_back(c.w);
+}
+
+std::vector<uint8_t> sequenceEncode(int pixels, int frames, int channels, bool rle, int fps, SequenceColor color)
+{
+  std::vector<uint8_t> out = {'C', 'L', 'D', 'F', 1, (uint8_t)channels, (uint8_t)(rle ? FRAMES_RLE : 0), 0};
+  sequencePut16(out, pixels);
+  sequencePut16(out, fps);
+  sequencePut32(out, frames);
+
+  if (!rle) {
+    for (int f=0; f<frames; f++)
+      for (int i=0; i<pixels; i++) sequencePixel(out, color(f, i), channels);
+    return out;
+  }
+
+  std::vector<uint8_t> runs;
+  for (int f=0; f<frames; f++) {
+    sequencePut32(out, runs.size());
+    for (int i=0; i<pixels; ) {
+      CRGBW c = color(f, i);
+      int n = 1;
+      while (i+n < pixels && n < 255 && color(f, i+n) == c) n++;
+      runs.push_back(n);
+      sequencePixel(runs, c, channels);
+      i += n;
+    }
+  }
+  out.insert(out.end(), runs.begin(), runs.end());
+  return out;
+}
+
+// Write to path, true if done
+bool sequenceSave(const char* path, const std::vector<uint8_t>& blob) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  bool done = fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+  return fclose(f) == 0 && done;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef framebuffer_h
+#define framebuffer_h
+
+// SHARED FRAMEBUFFER (/dev/shm/cloudled)
+//   one slot per emulated node (CLOUD_SLOT), written after each drawn frame, read by cloud/emulate.
+//   A slot is consistent when seq is even and did not change while reading it (seqlock).
+//   Layout (little endian, packed) kept in sync with cloud/emulate:
+//     header  magic u32, slots u32, pixels u32
+//     slot    seq u32, node u32, state u8, macro i8, position u8, count u8,
+//             now u32 (mesh ms), host u32 (monotonic ms), offset u32 (macro time offset),
+//             cpu u16 (permille), loops u16 (/s), msgOut u16, msgIn u16 (tenths /s), bytesOut u32, bytesIn u32 (/s),
+//             size u16, press u8 (written by cloud/emulate: 1 short, 2 long, 3 double long), pad u8,
+//             pixels r,g,b,w * FB_PIXELS
+//
+
+#include <Arduino.h>
+#include <K32_light.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define FB_NAME     "/cloudled"
+#define FB_MAGIC    0x434c4446      // CLDF
+#define FB_SLOTS    128
+#define FB_PIXELS   750
+
+#pragma pack(push, 1)
+struct FrameSlot {
+  volatile uint32_t seq;
+  uint32_t node;
+  uint8_t state;
+  int8_t macro;
+  uint8_t position;
+  uint8_t count;
+  uint32_t now;
+  uint32_t host;
+  uint32_t offset;
+  uint16_t cpu;
+  uint16_t loops;
+  uint16_t msgOut;
+  uint16_t msgIn;
+  uint32_t bytesOut;
+  uint32_t bytesIn;
+  uint16_t size;
+  volatile uint8_t press;
+  uint8_t pad;
+  CRGBW pixels[FB_PIXELS];
+};
+
+struct FrameBuffer {
+  uint32_t magic;
+  uint32_t slots;
+  uint32_t pixels;
+  FrameSlot slot[FB_SLOTS];
+};
+#pragma pack(pop)
+
+// Monotonic ms, the same clock for every process
+inline uint32_t hostMillis() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint32_t)(t.tv_sec * 1000ULL + t.tv_nsec / 1000000);
+}
+
+// Map (and create) the shared framebuffer, nullptr if it fails
+inline FrameBuffer* framebufferOpen()
+{
+  int fd = shm_open(FB_NAME, O_RDWR | O_CREAT, 0666);
+  if (fd < 0) { perror("FRAMEBUFFER: shm_open"); return nullptr; }
+  if (ftruncate(fd, sizeof(FrameBuffer)) < 0) { perror("FRAMEBUFFER: ftruncate"); close(fd); return nullptr; }
+  void* p = mmap(NULL, sizeof(FrameBuffer), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) { perror("FRAMEBUFFER: mmap"); return nullptr; }
+
+  FrameBuffer* fb = (FrameBuffer*)p;
+  fb->slots = FB_SLOTS;
+  fb->pixels = FB_PIXELS;
+  fb->magic = FB_MAGIC;
+  return fb;
+}
+
+// Slot write: begin() .. fill .. end()
+inline void slotBegin(FrameSlot& s) { s.seq = s.seq | 1; __sync_synchronize(); }
+inline void slotEnd(FrameSlot& s)   { __sync_synchronize(); s.seq = s.seq + 1; }
+
+#endif
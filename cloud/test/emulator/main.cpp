@@ -0,0 +1,138 @@
+// HOST EMULATOR (pio run -e emulator, run through cloud/emulate)
+//   the whole node of src/main.cpp (state machine, timers, button events, PeersPool, macros,
+//   transport, firmware share) as a Linux process, over the shims of test/shim:
+//     mesh     = UDP multicast on loopback (painlessMesh.h), CLOUD_NODE / CLOUD_SKEW / CLOUD_LOSS
+//     K32      = system id / hardware from CLOUD_ID / CLOUD_HW, timers run here
+//     restart  = exec of the same program (memory, preferences and mesh state lost, as on reboot)
+//   Frames are drawn at CLOUD_FPS (50) into the shared framebuffer slot CLOUD_SLOT (framebuffer.h),
+//   with the node CPU (getrusage) and message rates over EMU_STATS_MS, also logged:
+//     EMU: cpu <%>, <loops>/s, out <msg>/s <bytes>/s, in <msg>/s <bytes>/s
+//   Button presses come from the slot (cloud/emulate), loop() runs every CLOUD_LOOP_US (1000) µs.
+//
+
+#include "../../src/main.cpp"
+#include "framebuffer.h"
+#include <sys/resource.h>
+
+#define EMU_STATS_MS  5000
+
+char** emuArgv;
+FrameSlot* slot = nullptr;
+
+uint64_t cpuMicros() {
+  rusage r;
+  getrusage(RUSAGE_SELF, &r);
+  return (r.ru_utime.tv_sec + r.ru_stime.tv_sec) * 1000000ULL + r.ru_utime.tv_usec + r.ru_stime.tv_usec;
+}
+
+int envInt(const char* name, int fallback) {
+  const char* v = getenv(name);
+  return v ? atoi(v) : fallback;
+}
+
+// Reboot: same program, same environment
+void emuRestart() {
+  fflush(stdout);
+  mesh.stop();
+  execv("/proc/self/exe", emuArgv);
+  perror("EMU: restart");
+  exit(1);
+}
+
+// Button presses as the K32 buttons emit them
+void emuPress(int press) {
+  if (press == 1) k32->emit("btn/PUSH-off");
+  else if (press >= 2) {
+    for (int k=1; k<press; k++) k32->emit("btn/PUSH-long");
+    k32->emit("btn/PUSH-off");
+  }
+}
+
+// Logical strip into the slot
+void emuFrame(uint32_t now)
+{
+  int size = min(stripSIZE, FB_PIXELS);
+  slotBegin(*slot);
+  slot->node = mesh.getNodeId();
+  slot->state = state;
+  slot->macro = macroPlaying;
+  slot->position = pool->position();
+  slot->count = pool->count();
+  slot->now = now;
+  slot->host = hostMillis();
+  slot->offset = playingTimeOffset;
+  slot->size = size;
+  for (int i=0; i<size; i++)
+    slot->pixels[i] = outputs ? outputs->strips[outputs->which[i]]->pixels()[outputs->index[i]] : strip->pixels()[i];
+  slotEnd(*slot);
+}
+
+int main(int argc, char** argv)
+{
+  emuArgv = argv;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  ESP.onRestart = emuRestart;
+
+  int slotIndex = envInt("CLOUD_SLOT", 0);
+  uint32_t framePeriod = 1000 / max(1, envInt("CLOUD_FPS", 50));
+  uint32_t loopUs = envInt("CLOUD_LOOP_US", 1000);
+
+  FrameBuffer* fb = framebufferOpen();
+  if (!fb || slotIndex < 0 || slotIndex >= FB_SLOTS) {
+    Serial.printf("EMU: no framebuffer slot %d\n", slotIndex);
+    return 1;
+  }
+  slot = &fb->slot[slotIndex];
+  slot->press = 0;
+
+  setup();
+
+  uint32_t frameAt = 0;
+  uint32_t statsAt = millis();
+  uint64_t cpuAt = cpuMicros();
+  uint32_t loops = 0, sent = 0, received = 0, bytesSent = 0, bytesReceived = 0;
+
+  while (true)
+  {
+    if (slot->press) {
+      int press = slot->press;
+      slot->press = 0;
+      emuPress(press);
+    }
+
+    loop();
+    k32->timer->update();
+    loops++;
+
+    uint32_t ms = millis();
+    if (ms - frameAt >= framePeriod) {
+      frameAt = ms;
+      light->update();
+      emuFrame(meshMillis());
+    }
+
+    // Node stats
+    uint32_t elapsed = ms - statsAt;
+    if (elapsed >= EMU_STATS_MS) {
+      uint64_t cpu = cpuMicros();
+      slot->cpu = (cpu - cpuAt) / elapsed;
+      slot->loops = loops * 1000 / elapsed;
+      slot->msgOut = (mesh.sent - sent) * 10000 / elapsed;
+      slot->msgIn = (mesh.received - received) * 10000 / elapsed;
+      slot->bytesOut = (mesh.bytesSent - bytesSent) * 1000 / elapsed;
+      slot->bytesIn = (mesh.bytesReceived - bytesReceived) * 1000 / elapsed;
+      Serial.printf("EMU: cpu %u.%u%%, %u loops/s, out %u.%u msg/s %u B/s, in %u.%u msg/s %u B/s\n", 
+                    slot->cpu / 10, slot->cpu % 10, slot->loops, slot->msgOut / 10, slot->msgOut % 10, slot->bytesOut, 
+                    slot->msgIn / 10, slot->msgIn % 10, slot->bytesIn);
+      statsAt = ms;
+      cpuAt = cpu;
+      loops = 0;
+      sent = mesh.sent;
+      received = mesh.received;
+      bytesSent = mesh.bytesSent;
+      bytesReceived = mesh.bytesReceived;
+    }
+
+    usleep(loopUs);
+  }
+}
@@ -0,0 +1,33 @@
+// HOST GOLDEN FRAMES (pio run -e golden -t exec)
+//   the CLOUD_GOLDEN timeline of src/golden.h on Linux, pixels dumped (GOLDEN_DUMP):
+//   every macro at 3 position / peers tuples, the DMX strip pix x mirror sweep, on an Atom strip.
+//   Reference of the tree in test/golden/reference.txt.gz, diff a run against it:
+//     pio run -e golden -t exec > run.txt && ./golden diff test/golden/reference.txt.gz run.txt
+//
+
+#include <Arduino.h>
+#include <K32.h>
+
+#include "light.h"
+#include "anim_cloudled.h"
+#include "macros.h"
+#include "anim_dmx_strip.h"
+#include "golden.h"
+
+#define GOLDEN_SIZE 25
+
+int main(int argc, char** argv)
+{
+  K32* k32 = new K32();
+  lightSetup(k32, GOLDEN_SIZE, LED_WS2812B_V3, 27);
+  addMacros();
+  spatial.load(k32->system->channel());     // sweep: default map, as setup() does
+  spatial.build(GOLDEN_SIZE);
+
+  Anim_dmx_strip* dmx = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(GOLDEN_SIZE)) );
+  light->anim( "dmx", dmx, GOLDEN_SIZE )
+      ->drawTo(strip);
+
+  goldenRun(dmx);
+  return 0;
+}
@@ -0,0 +1,266 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// HOST SHIM (native envs, see platformio.ini)
+//   the part of Arduino / ESP32 used by src/, on top of the C++ library:
+//   String, Serial (stdout), millis() / micros(), random(), ESP (heap counter).
+//   Header only: a test or host program is one translation unit with its own main().
+//
+//   Time is the monotonic clock, or driven by hand by simulations:
+//     hostClock.manual = true;  hostClock.us = ...;
+//
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <cmath>
+#include <cctype>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI      3.1415926535897932384626433832795
+#define HEX     16
+#define DEC     10
+#define INPUT   0x01
+#define OUTPUT  0x03
+#define LOW     0
+#define HIGH    1
+
+using std::min;
+using std::max;
+using std::abs;
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return LOW; }
+
+
+/// CLOCK
+
+struct HostClock {
+  bool manual = false;
+  uint64_t us = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  uint64_t now() {
+    if (manual) return us;
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+inline HostClock hostClock;
+
+inline uint32_t micros() { return (uint32_t)hostClock.now(); }
+inline uint32_t millis() { return (uint32_t)(hostClock.now() / 1000); }
+
+inline void delay(uint32_t ms) {
+  if (hostClock.manual) hostClock.us += (uint64_t)ms * 1000;
+  else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(uint32_t us) {
+  if (hostClock.manual) hostClock.us += us;
+  else std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+
+/// RANDOM (deterministic once seeded)
+
+inline long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+inline long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+
+/// STRING
+
+class String : public std::string {
+  public:
+    String() {}
+    String(const char* s) : std::string(s ? s : "") {}
+    String(const std::string& s) : std::string(s) {}
+    String(char c) : std::string(1, c) {}
+    String(int v, unsigned char base = DEC) : std::string(format(v, base)) {}
+    String(unsigned int v, unsigned char base = DEC) : std::string(formatU(v, base)) {}
+    String(long v, unsigned char base = DEC) : std::string(format(v, base)) {}
+    String(unsigned long v, unsigned char base = DEC) : std::string(formatU(v, base)) {}
+    String(long long v) : std::string(std::to_string(v)) {}
+    String(unsigned long long v) : std::string(std::to_string(v)) {}
+    String(float v, unsigned char decimals = 2) : std::string(formatF(v, decimals)) {}
+    String(double v, unsigned char decimals = 2) : std::string(formatF(v, decimals)) {}
+
+    unsigned int length() const { return size(); }
+    char charAt(unsigned int i) const { return i < size() ? (*this)[i] : 0; }
+
+    int indexOf(char c, unsigned int from = 0) const { return pos(find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return pos(find(s, from)); }
+    int lastIndexOf(char c) const { return pos(rfind(c)); }
+
+    String substring(unsigned int from) const { return from >= size() ? String() : String(substr(from)); }
+    String substring(unsigned int from, unsigned int to) const {
+      if (from > to) std::swap(from, to);
+      return from >= size() ? String() : String(substr(from, to - from));
+    }
+
+    bool startsWith(const String& s) const { return compare(0, s.size(), s) == 0; }
+    bool endsWith(const String& s) const { return size() >= s.size() && compare(size() - s.size(), s.size(), s) == 0; }
+    bool equals(const String& s) const { return *this == s; }
+
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return atof(c_str()); }
+
+    void trim() {
+      size_t a = find_first_not_of(" \t\r\n");
+      size_t b = find_last_not_of(" \t\r\n");
+      *this = (a == npos) ? String() : String(substr(a, b - a + 1));
+    }
+    void toUpperCase() { for (char& c : *this) c = toupper(c); }
+    void toLowerCase() { for (char& c : *this) c = tolower(c); }
+    void replace(const String& from, const String& to) {
+      if (from.empty()) return;
+      for (size_t p = find(from); p != npos; p = find(from, p + to.size())) std::string::replace(p, from.size(), to);
+    }
+    void toCharArray(char* buf, unsigned int n) const {
+      if (!n) return;
+      strncpy(buf, c_str(), n - 1);
+      buf[n - 1] = 0;
+    }
+    void getBytes(unsigned char* buf, unsigned int n) const { toCharArray((char*)buf, n); }
+
+    bool concat(const String& s) { append(s); return true; }
+    String& operator+=(const String& s) { append(s); return *this; }
+    String& operator+=(const char* s) { append(s); return *this; }
+    String& operator+=(char c) { push_back(c); return *this; }
+
+  private:
+    static int pos(size_t p) { return p == npos ? -1 : (int)p; }
+
+    static std::string formatU(unsigned long long v, int base) {
+      if (base == DEC) return std::to_string(v);
+      std::string s;
+      do { s.insert(s.begin(), "0123456789abcdef"[v % base]); v /= base; } while (v);
+      return s;
+    }
+    static std::string format(long long v, int base) {
+      if (base == DEC) return std::to_string(v);
+      return formatU((unsigned long)v, base);
+    }
+    static std::string formatF(double v, int decimals) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+      return buf;
+    }
+};
+
+inline String operator+(const String& a, const String& b) { String s(a); s.append(b); return s; }
+inline String operator+(const String& a, const char* b) { String s(a); s.append(b); return s; }
+inline String operator+(const char* a, const String& b) { String s(a); s.append(b); return s; }
+inline String operator+(const String& a, char b) { String s(a); s.push_back(b); return s; }
+
+
+/// SERIAL (stdout)
+//   a test can read what is printed (captured) and feed what is read (input)
+
+class HardwareSerial {
+  public:
+    std::string* captured = nullptr;    // printed text goes here instead of stdout
+    std::string input;                  // text to read
+
+    void begin(unsigned long) {}
+    void setTimeout(unsigned long) {}
+    int available() { return input.size(); }
+    int read() {
+      if (input.empty()) return -1;
+      int c = (uint8_t)input[0];
+      input.erase(0, 1);
+      return c;
+    }
+    size_t readBytes(uint8_t* buf, size_t n) {
+      n = min(n, input.size());
+      memcpy(buf, input.data(), n);
+      input.erase(0, n);
+      return n;
+    }
+    String readStringUntil(char end) {
+      size_t p = input.find(end);
+      String s(input.substr(0, p));
+      input.erase(0, p == std::string::npos ? p : p + 1);
+      return s;
+    }
+
+    size_t write(uint8_t c) { return out((const char*)&c, 1); }
+    size_t write(const uint8_t* buf, size_t n) { return out((const char*)buf, n); }
+
+    void print(const String& s) { out(s.c_str(), s.size()); }
+    void println(const String& s) { out(s.c_str(), s.size()); out("\n", 1); }
+    void println() { out("\n", 1); }
+    void flush() { fflush(stdout); }
+
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+      va_list args;
+      va_start(args, format);
+      char buf[1024];
+      int n = vsnprintf(buf, sizeof(buf), format, args);
+      va_end(args);
+      if (n >= (int)sizeof(buf)) {
+        std::string big(n + 1, 0);
+        va_start(args, format);
+        vsnprintf(&big[0], n + 1, format, args);
+        va_end(args);
+        out(big.c_str(), n);
+      }
+      else if (n > 0) out(buf, n);
+      return n;
+    }
+
+  private:
+    size_t out(const char* p, size_t n) {
+      if (captured) captured->append(p, n);
+      else fwrite(p, 1, n, stdout);
+      return n;
+    }
+};
+
+inline HardwareSerial Serial;
+
+
+/// LOG (K32_log.h on the board)
+
+#define LOG(x)              Serial.println(x)
+#define LOGINL(x)           Serial.print(x)
+#define LOGF(x, ...)        Serial.printf(x, __VA_ARGS__)
+#define LOGF2(x, ...)       Serial.printf(x, __VA_ARGS__)
+#define LOGF3(x, ...)       Serial.printf(x, __VA_ARGS__)
+
+
+/// ESP
+
+#define HOST_HEAP  (4 * 1024 * 1024)      // reported as total heap
+
+class EspClass {
+  public:
+    size_t heapUsed = 0;              // bytes allocated, counted by the host program if it wants to
+    uint32_t sketchSize = 0;
+    int restarts = 0;
+    void (*onRestart)() = nullptr;    // host program reboot (emulator), counted only otherwise
+
+    uint32_t getFreeHeap() { return HOST_HEAP - heapUsed; }
+    uint32_t getSketchSize() { return sketchSize; }
+    String getSketchMD5() { return String(); }
+    void restart() {
+      restarts++;
+      if (onRestart) onRestart();
+    }
+};
+
+inline EspClass ESP;
+
+#endif
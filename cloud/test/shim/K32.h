@@ -0,0 +1,84 @@
+#ifndef K32_h
+#define K32_h
+
+// HOST SHIM: K32 system, timers, events
+//   id / hardware come from the environment (CLOUD_ID, CLOUD_HW), default 1 / DevC.
+//   reset() restarts through ESP.restart() (ESP.onRestart).
+//   Timers and events run when the host program calls timer->update() / emit().
+//
+
+#include <Arduino.h>
+#include <K32_light.h>
+#include <functional>
+#include <vector>
+
+struct Orderz {
+  String engine;
+};
+
+class K32_system {
+  public:
+    K32_system() {
+      const char* id = getenv("CLOUD_ID");
+      const char* hw = getenv("CLOUD_HW");
+      _id = id ? atoi(id) : 1;
+      _channel = _id;
+      _hw = hw ? atoi(hw) : 0;
+    }
+
+    int id() { return _id; }
+    void id(int v) { _id = v; }
+    int channel() { return _channel; }
+    void channel(int v) { _channel = v; }
+    int hw() { return _hw; }
+    void hw(int v) { _hw = v; }
+    void reset() { ESP.restart(); }
+
+  private:
+    int _id, _channel, _hw;
+};
+
+class K32_timer {
+  public:
+    void every(uint32_t period, std::function<void()> callback) {
+      timers.push_back({period, millis(), callback});
+    }
+
+    void update() {
+      uint32_t now = millis();
+      for (Timer& t : timers)
+        if (now - t.last >= t.period) {
+          t.last = now;
+          t.callback();
+        }
+    }
+
+  private:
+    struct Timer {
+      uint32_t period;
+      uint32_t last;
+      std::function<void()> callback;
+    };
+    std::vector<Timer> timers;
+};
+
+class K32 {
+  public:
+    K32_system* system = new K32_system;
+    K32_timer* timer = new K32_timer;
+
+    void on(String event, std::function<void(Orderz*)> callback) {
+      events.push_back({event, callback});
+    }
+
+    void emit(String event) {
+      Orderz order;
+      order.engine = event;
+      for (auto& e : events) if (e.first == event) e.second(&order);
+    }
+
+  private:
+    std::vector<std::pair<String, std::function<void(Orderz*)>>> events;
+};
+
+#endif
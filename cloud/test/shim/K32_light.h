@@ -0,0 +1,296 @@
+#ifndef K32_light_h
+#define K32_light_h
+
+// HOST SHIM: K32 light (CRGBW, fixtures, anims, modulators)
+//   anims draw straight into their fixtures, as on the board.
+//   There is no anim task: K32_light::update() draws the playing anims
+//   whose data changed (or with a playing modulator), the host program calls it.
+//
+
+#include <Arduino.h>
+#include <vector>
+#include <map>
+
+#define ANIM_DATA_SLOTS 24
+
+
+/// COLOR
+
+struct CRGBW {
+  union {
+    struct { uint8_t r, g, b, w; };
+    uint8_t raw[4];
+  };
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000, White = 0xFFFFFF, Red = 0xFF0000, Lime = 0x00FF00, Blue = 0x0000FF,
+    Yellow = 0xFFFF00, Magenta = 0xFF00FF, Cyan = 0x00FFFF, Orange = 0xFFA500, Tomato = 0xFF6347,
+    DodgerBlue = 0x1E90FF, Turquoise = 0x40E0D0, LightYellow = 0xFFFFE0, DarkBlue = 0x00008B, HotPink = 0xFF69B4
+  };
+
+  CRGBW() : r(0), g(0), b(0), w(0) {}
+  CRGBW(int ir, int ig, int ib, int iw = 0) : r(ir), g(ig), b(ib), w(iw) {}
+  CRGBW(HTMLColorCode code) : r(code >> 16), g(code >> 8), b(code), w(0) {}
+
+  // scale by 8bit value
+  CRGBW& operator%=(uint8_t scale) {
+    r = r * scale / 255;
+    g = g * scale / 255;
+    b = b * scale / 255;
+    w = w * scale / 255;
+    return *this;
+  }
+
+  // scale each channel by the other color
+  CRGBW& operator%=(const CRGBW& scale) {
+    r = r * scale.r / 255;
+    g = g * scale.g / 255;
+    b = b * scale.b / 255;
+    w = w * scale.w / 255;
+    return *this;
+  }
+
+  CRGBW operator%(uint8_t scale) const {
+    CRGBW c = *this;
+    return c %= scale;
+  }
+
+  // saturated add
+  CRGBW& operator+=(const CRGBW& o) {
+    r = min(255, r + o.r);
+    g = min(255, g + o.g);
+    b = min(255, b + o.b);
+    w = min(255, w + o.w);
+    return *this;
+  }
+
+  bool operator==(const CRGBW& o) const { return r == o.r && g == o.g && b == o.b && w == o.w; }
+  bool operator!=(const CRGBW& o) const { return !(*this == o); }
+
+  // color wheel, 3 sectors
+  CRGBW& setHue(uint8_t hue) {
+    int h = hue;
+    if (h < 85)       { r = 255 - h*3; g = h*3;       b = 0; }
+    else if (h < 170) { h -= 85;  r = 0;       g = 255 - h*3; b = h*3; }
+    else              { h -= 170; r = h*3;     g = 0;         b = 255 - h*3; }
+    w = 0;
+    return *this;
+  }
+};
+
+
+/// FIXTURE
+
+class K32_fixture {
+  public:
+    K32_fixture(int size = 0) : _pixels(size) {}
+    virtual ~K32_fixture() {}
+
+    void pix(int pixel, CRGBW color) {
+      if (pixel >= 0 && pixel < size()) _pixels[pixel] = color;
+    }
+
+    void clear() {
+      std::fill(_pixels.begin(), _pixels.end(), CRGBW());
+    }
+
+    int size() { return _pixels.size(); }
+    const CRGBW* pixels() { return _pixels.data(); }
+
+  protected:
+    std::vector<CRGBW> _pixels;
+};
+
+
+/// MODULATORS: value from millis(), applied to their data slots before draw
+
+class K32_modulator {
+  public:
+    virtual ~K32_modulator() {}
+
+    K32_modulator* param(int i, int value) { if (i >= 0 && i < 4) params[i] = value; return this; }
+    K32_modulator* at(int slot) { slots.push_back(slot); return this; }
+    K32_modulator* period(int ms) { _period = max(1, ms); return this; }
+    K32_modulator* play() { _playing = true; return this; }
+    K32_modulator* stop() { _playing = false; return this; }
+    bool isPlaying() { return _playing; }
+
+    // 0-255
+    virtual uint8_t value() { return 255; }
+
+    void apply(int* data) {
+      if (!_playing) return;
+      uint8_t v = value();
+      for (int s : slots) data[s] = data[s] * v / 255;
+    }
+
+  protected:
+    int params[4] = {0};
+    int _period = 1000;
+    bool _playing = false;
+    std::vector<int> slots;
+};
+
+// on for params[0] ms every period
+class K32_mod_pulse : public K32_modulator {
+  public:
+    uint8_t value() { return (millis() % _period) < (uint32_t)params[0] ? 255 : 0; }
+};
+
+class K32_mod_sinus : public K32_modulator {
+  public:
+    uint8_t value() { return 127.5f + 127.5f * sinf(2 * PI * (millis() % _period) / _period); }
+};
+
+
+/// ANIM
+
+class K32_anim {
+  public:
+    int data[ANIM_DATA_SLOTS] = {0};
+
+    virtual ~K32_anim() {}
+    virtual void init() {}
+    virtual void draw(int data[ANIM_DATA_SLOTS]) = 0;
+
+    // K32_light::anim()
+    K32_anim* setup(String name, int size, int offset) {
+      _name = name;
+      _size = size;
+      _offset = offset;
+      return this;
+    }
+
+    String name() { return _name; }
+    int size() { return _size; }
+
+    K32_anim* drawTo(K32_fixture* fixture) {
+      _fixtures.push_back(fixture);
+      if (!_size) _size = fixture->size();
+      return this;
+    }
+
+    K32_anim* master(int m) { _master = m; return this; }
+    int master() { return _master; }
+
+    K32_anim* play() {
+      init();
+      _playing = true;
+      _dirty = true;
+      return this;
+    }
+    K32_anim* play(uint32_t) { return play(); }
+    K32_anim* stop() { _playing = false; return this; }
+    bool isPlaying() { return _playing; }
+
+    // draws run in K32_light::update(), nothing to wait for
+    K32_anim* wait(int timeout = 0) { return this; }
+
+    K32_anim* push(int* frame, int count) {
+      for (int i=0; i<count && i<ANIM_DATA_SLOTS; i++) data[i] = frame[i];
+      _dirty = true;
+      return this;
+    }
+    template<class... Ints> K32_anim* push(int first, Ints... rest) {
+      int frame[] = {first, (int)rest...};
+      return push(frame, 1 + sizeof...(rest));
+    }
+    K32_anim* push() { _dirty = true; return this; }
+    K32_anim* set(int i, int value) { if (i >= 0 && i < ANIM_DATA_SLOTS) data[i] = value; return this; }
+
+    K32_modulator* mod(String name, K32_modulator* m) { _mods[name] = m; return m; }
+    K32_modulator* mod(String name) { return _mods.count(name) ? _mods[name] : nullptr; }
+
+    // Draw now if needed (host: K32_light::update())
+    bool refresh() {
+      bool modulated = false;
+      for (auto& m : _mods) modulated |= m.second->isPlaying();
+      if (!_playing || (!_dirty && !modulated)) return false;
+      _dirty = false;
+
+      int frame[ANIM_DATA_SLOTS];
+      memcpy(frame, data, sizeof(frame));
+      for (auto& m : _mods) m.second->apply(frame);
+      draw(frame);
+      return true;
+    }
+
+    // Drawing
+    void pixel(int i, CRGBW color) {
+      if (i < 0 || i >= _size) return;
+      if (_master < 255) color %= (uint8_t)_master;
+      for (K32_fixture* f : _fixtures) f->pix(_offset + i, color);
+    }
+
+    void pixel(int start, int count, CRGBW color) {
+      for (int i=start; i<start+count; i++) pixel(i, color);
+    }
+
+    void all(CRGBW color) { pixel(0, _size, color); }
+    void clear() { all(CRGBW()); }
+
+  private:
+    String _name;
+    int _size = 0;
+    int _offset = 0;
+    int _master = 255;
+    bool _playing = false;
+    bool _dirty = false;
+    std::vector<K32_fixture*> _fixtures;
+    std::map<std::string, K32_modulator*> _mods;
+};
+
+
+/// LIBRARY ANIMS
+
+// data[2] = level % (full if not given), flashes are not timed on host
+class Anim_flash : public K32_anim {
+  public:
+    void draw(int data[ANIM_DATA_SLOTS]) {
+      int level = data[2] ? data[2] : 100;
+      this->all(CRGBW{CRGBW::White} % (uint8_t)(level * 255 / 100));
+    }
+};
+
+class Anim_off : public K32_anim {
+  public:
+    void draw(int data[ANIM_DATA_SLOTS]) { this->clear(); }
+};
+
+
+/// LIGHT
+
+class K32;
+
+class K32_light {
+  public:
+    K32_light(K32* k32) {}
+
+    void loadprefs() {}
+
+    void addFixture(K32_fixture* fixture) {
+      fixtures.push_back(fixture);
+    }
+
+    K32_anim* anim(String name, K32_anim* anim, int size = 0, int offset = 0) {
+      anims.push_back(anim->setup(name, size, offset));
+      return anim;
+    }
+
+    K32_anim* anim(String name) {
+      for (K32_anim* a : anims) if (a->name() == name) return a;
+      return nullptr;
+    }
+
+    // Draw anims that need it, returns true if any did
+    bool update() {
+      bool drawn = false;
+      for (K32_anim* a : anims) drawn |= a->refresh();
+      return drawn;
+    }
+
+    std::vector<K32_fixture*> fixtures;
+    std::vector<K32_anim*> anims;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef K32_wifi_h
+#define K32_wifi_h
+
+// HOST SHIM: never connects
+
+#include <K32.h>
+
+class K32_wifi {
+  public:
+    K32_wifi(K32* k32) {}
+    void setHostname(String name) {}
+    void connect(const char* ssid, const char* password) {}
+    bool isConnected() { return false; }
+    bool otaInProgress() { return false; }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef Preferences_h
+#define Preferences_h
+
+// HOST SHIM: namespaces kept in memory for the process life,
+//   per scope: a simulation running several nodes in one process sets scope() to the node.
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+class Preferences {
+  public:
+    bool begin(const char* name, bool readOnly = false) {
+      space = &store()[scope() + "/" + name];
+      return true;
+    }
+
+    void end() { space = nullptr; }
+    bool clear() { if (space) space->clear(); return space; }
+    bool remove(const char* key) { return space && space->erase(key); }
+    bool isKey(const char* key) { return space && space->count(key); }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+      if (!space) return 0;
+      (*space)[key].assign((const uint8_t*)value, (const uint8_t*)value + len);
+      return len;
+    }
+
+    size_t getBytes(const char* key, void* buf, size_t len) {
+      if (!isKey(key)) return 0;
+      std::vector<uint8_t>& v = (*space)[key];
+      if (v.size() > len) return 0;
+      memcpy(buf, v.data(), v.size());
+      return v.size();
+    }
+
+    size_t getBytesLength(const char* key) { return isKey(key) ? (*space)[key].size() : 0; }
+
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+      uint32_t v = defaultValue;
+      getBytes(key, &v, sizeof(v));
+      return v;
+    }
+
+    size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) {
+      int32_t v = defaultValue;
+      getBytes(key, &v, sizeof(v));
+      return v;
+    }
+
+    static std::string& scope() {
+      static std::string s;
+      return s;
+    }
+
+    // All namespaces (tests can wipe them)
+    static std::map<std::string, std::map<std::string, std::vector<uint8_t>>>& store() {
+      static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> s;
+      return s;
+    }
+
+  private:
+    std::map<std::string, std::vector<uint8_t>>* space = nullptr;
+};
+
+#endif
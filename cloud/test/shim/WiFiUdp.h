@@ -0,0 +1,90 @@
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+// HOST SHIM: WiFiUDP on a non-blocking POSIX socket (any interface)
+
+#include <Arduino.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class WiFiUDP {
+  public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port) {
+      stop();
+      fd = socket(AF_INET, SOCK_DGRAM, 0);
+      if (fd < 0) return 0;
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(port);
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { stop(); return 0; }
+      return 1;
+    }
+
+    void stop() {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+
+    // Next packet: its size, 0 if none
+    int parsePacket() {
+      if (fd < 0) return 0;
+      ssize_t n = recv(fd, packet, sizeof(packet), 0);
+      length = n > 0 ? n : 0;
+      position = 0;
+      return length;
+    }
+
+    int available() { return length - position; }
+
+    int read() {
+      if (position >= length) return -1;
+      return packet[position++];
+    }
+
+    int read(uint8_t* buf, size_t len) {
+      if (position >= length) return -1;
+      int n = min((int)len, length - position);
+      memcpy(buf, packet + position, n);
+      position += n;
+      return n;
+    }
+
+    void flush() { position = length; }
+
+    // Send
+    int beginPacket(const char* host, uint16_t port) {
+      to = {};
+      to.sin_family = AF_INET;
+      to.sin_port = htons(port);
+      inet_pton(AF_INET, host, &to.sin_addr);
+      out.clear();
+      if (fd < 0) fd = socket(AF_INET, SOCK_DGRAM, 0);
+      return fd >= 0;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) { out.append((const char*)buf, len); return len; }
+    size_t write(uint8_t c) { out.push_back(c); return 1; }
+
+    int endPacket() {
+      return sendto(fd, out.data(), out.size(), 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)out.size();
+    }
+
+  private:
+    int fd = -1;
+    uint8_t packet[1500];
+    int length = 0;
+    int position = 0;
+    sockaddr_in to = {};
+    std::string out;
+};
+
+#endif
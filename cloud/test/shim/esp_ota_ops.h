@@ -0,0 +1,46 @@
+#ifndef esp_ota_ops_h
+#define esp_ota_ops_h
+
+// HOST SHIM: two app partitions (ota_0 / ota_1), created on first use.
+//   hostOta() holds the running one and the boot choice of the current board,
+//   a simulation of several nodes points hostOtaBoard() to each node's own.
+
+#include <esp_partition.h>
+
+#define HOST_OTA_SIZE  0x140000
+
+struct HostOta {
+  esp_partition_t* slots[2] = {nullptr, nullptr};
+  int running = 0;
+  int boot = 0;
+
+  HostOta() {
+    slots[0] = hostPartition("ota_0", HOST_OTA_SIZE, ESP_PARTITION_TYPE_APP);
+    slots[1] = hostPartition("ota_1", HOST_OTA_SIZE, ESP_PARTITION_TYPE_APP);
+  }
+};
+
+inline HostOta*& hostOtaBoard() {
+  static HostOta* board = nullptr;
+  return board;
+}
+
+inline HostOta& hostOta() {
+  if (!hostOtaBoard()) hostOtaBoard() = new HostOta;
+  return *hostOtaBoard();
+}
+
+inline const esp_partition_t* esp_ota_get_running_partition() {
+  return hostOta().slots[hostOta().running];
+}
+
+inline const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start) {
+  return hostOta().slots[1 - hostOta().running];
+}
+
+inline esp_err_t esp_ota_set_boot_partition(const esp_partition_t* p) {
+  for (int k=0; k<2; k++) if (hostOta().slots[k] == p) { hostOta().boot = k; return ESP_OK; }
+  return ESP_ERR_INVALID_ARG;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef esp_partition_h
+#define esp_partition_h
+
+// HOST SHIM: partitions are RAM buffers (flash rules: erase by sector to 0xFF, write only clears bits)
+//   a host program or test registers them: hostPartition("frames", size) / hostPartitions()
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <memory>
+
+typedef int esp_err_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_SIZE        0x104
+#define SPI_FLASH_SEC_SIZE          4096
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xff } esp_partition_subtype_t;
+typedef enum { SPI_FLASH_MMAP_DATA, SPI_FLASH_MMAP_INST } spi_flash_mmap_memory_t;
+
+struct esp_partition_t {
+  int type;
+  char label[17];
+  uint32_t address;
+  uint32_t size;
+  uint8_t* data;
+};
+
+inline std::vector<std::unique_ptr<esp_partition_t>>& hostPartitions() {
+  static std::vector<std::unique_ptr<esp_partition_t>> parts;
+  return parts;
+}
+
+// New erased partition
+inline esp_partition_t* hostPartition(const char* label, uint32_t size, int type = ESP_PARTITION_TYPE_DATA) {
+  esp_partition_t* p = new esp_partition_t();
+  p->type = type;
+  strncpy(p->label, label, 16);
+  p->size = size;
+  p->data = new uint8_t[size];
+  memset(p->data, 0xff, size);
+  hostPartitions().emplace_back(p);
+  return p;
+}
+
+inline const esp_partition_t* esp_partition_find_first(int type, int subtype, const char* label) {
+  for (auto& p : hostPartitions())
+    if (p->type == type && (!label || strcmp(p->label, label) == 0)) return p.get();
+  return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* p, size_t offset, void* dst, size_t size) {
+  if (!p || offset + size > p->size) return ESP_ERR_INVALID_SIZE;
+  memcpy(dst, p->data + offset, size);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t* p, size_t offset, const void* src, size_t size) {
+  if (!p || offset + size > p->size) return ESP_ERR_INVALID_SIZE;
+  for (size_t i=0; i<size; i++) p->data[offset + i] &= ((const uint8_t*)src)[i];
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t size) {
+  if (!p || offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+  if (offset + size > p->size) return ESP_ERR_INVALID_SIZE;
+  memset(p->data + offset, 0xff, size);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t* p, size_t offset, size_t size, spi_flash_mmap_memory_t memory,
+                                    const void** out, spi_flash_mmap_handle_t* handle) {
+  if (!p || offset + size > p->size) return ESP_ERR_INVALID_SIZE;
+  *out = p->data + offset;
+  *handle = 0;
+  return ESP_OK;
+}
+
+inline void spi_flash_munmap(spi_flash_mmap_handle_t handle) {}
+
+#endif
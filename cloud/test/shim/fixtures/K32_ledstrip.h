@@ -0,0 +1,33 @@
+#ifndef K32_ledstrip_h
+#define K32_ledstrip_h
+
+// HOST SHIM: LED strip = pixel buffer (no wire)
+
+#include <K32_light.h>
+
+enum led_types {
+  LED_WS2812_V1,
+  LED_WS2812B_V1,
+  LED_WS2812B_V2,
+  LED_WS2812B_V3,
+  LED_WS2813_V1,
+  LED_WS2813_V2,
+  LED_WS2813_V3,
+  LED_WS2813_V4,
+  LED_WS2815_V1,
+  LED_SK6812_V1,
+  LED_SK6812W_V1,
+  LED_SK6812W_V3,
+  LED_TYPES
+};
+
+class K32_ledstrip : public K32_fixture {
+  public:
+    K32_ledstrip(int channel, int pin, int type, int size) : K32_fixture(size), channel(channel), pin(pin), type(type) {}
+
+    int channel;
+    int pin;
+    int type;
+};
+
+#endif
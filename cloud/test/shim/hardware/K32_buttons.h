@@ -0,0 +1,14 @@
+#ifndef K32_buttons_h
+#define K32_buttons_h
+
+// HOST SHIM: no buttons, the host program emits btn/<name>-off / btn/<name>-long on k32
+
+#include <K32.h>
+
+class K32_buttons {
+  public:
+    K32_buttons(K32* k32) {}
+    void add(int pin, String name) {}
+};
+
+#endif
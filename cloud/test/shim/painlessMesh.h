@@ -0,0 +1,281 @@
+#ifndef painlessMesh_h
+#define painlessMesh_h
+
+// HOST SHIM: painlessMesh over UDP multicast on loopback (239.255.67.76:<mesh port>)
+//   one datagram per message:  mesh(u32) type(u8) from(u32) to(u32) payload
+//     mesh = hash of the mesh prefix, type = hello / broadcast / single (single: dropped by the others)
+//   every node says hello each second and drops the nodes not heard for 3 s: full mesh topology.
+//   Node id from CLOUD_NODE (pid based otherwise), node time = monotonic clock (every process in sync)
+//   + CLOUD_SKEW µs, CLOUD_LOSS % of received messages dropped.
+//   Scheduler tasks run in update(), as with painlessMesh.
+//
+
+#include <Arduino.h>
+#include <list>
+#include <vector>
+#include <map>
+#include <functional>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+template<class T> using SimpleList = std::list<T>;
+
+#define TASK_MILLISECOND  1UL
+#define TASK_SECOND       1000UL
+#define TASK_FOREVER      -1
+#define TASK_ONCE         1
+
+enum debugType { ERROR = 1, STARTUP = 2, MESH_STATUS = 4, CONNECTION = 8, SYNC = 16, COMMUNICATION = 32, GENERAL = 64, MSG_TYPES = 128, REMOTE = 256 };
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+
+#define MESH_GROUP    "239.255.67.76"
+#define MESH_HELLO_MS 1000
+#define MESH_LOST_MS  3000
+
+
+/// SCHEDULER
+
+class Task {
+  public:
+    Task(unsigned long interval, long iterations, void (*callback)()) 
+      : interval(interval), iterations(iterations), callback(callback) {}
+
+    void enable() { enabled = true; last = millis(); done = 0; }
+    void disable() { enabled = false; }
+    bool isEnabled() { return enabled; }
+    void setInterval(unsigned long ms) { interval = ms; }
+
+    void run(uint32_t now) {
+      if (!enabled || now - last < interval) return;
+      last = now;
+      if (callback) callback();
+      if (iterations != TASK_FOREVER && ++done >= iterations) enabled = false;
+    }
+
+  private:
+    unsigned long interval;
+    long iterations;
+    void (*callback)();
+    bool enabled = false;
+    uint32_t last = 0;
+    long done = 0;
+};
+
+class Scheduler {
+  public:
+    void addTask(Task& task) { tasks.push_back(&task); }
+    void deleteTask(Task& task) { tasks.erase(std::remove(tasks.begin(), tasks.end(), &task), tasks.end()); }
+
+    void execute() {
+      uint32_t now = millis();
+      for (Task* t : tasks) t->run(now);
+    }
+
+  private:
+    std::vector<Task*> tasks;
+};
+
+
+/// MESH
+
+class painlessMesh {
+  public:
+    // Messages / bytes on the socket since start
+    uint32_t sent = 0, received = 0, bytesSent = 0, bytesReceived = 0;
+
+    void setDebugMsgTypes(uint16_t types) {}
+
+    void init(String prefix, String password, Scheduler* scheduler, uint16_t port = 5555, 
+              WiFiMode_t mode = WIFI_AP_STA, uint8_t channel = 1, uint8_t hidden = 0)
+    {
+      this->scheduler = scheduler;
+      const char* node = getenv("CLOUD_NODE");
+      const char* skew = getenv("CLOUD_SKEW");
+      const char* loss = getenv("CLOUD_LOSS");
+      nodeId = node ? strtoul(node, NULL, 10) : (uint32_t)getpid() * 2654435761u;
+      skewUs = skew ? atoi(skew) : 0;
+      lossPercent = loss ? atoi(loss) : 0;
+      meshHash = 2166136261u;
+      for (char c : prefix) meshHash = (meshHash ^ (uint8_t)c) * 16777619u;
+
+      fd = socket(AF_INET, SOCK_DGRAM, 0);
+      int on = 1;
+      int buffer = 4 << 20;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(port);
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) perror("MESH: bind");
+
+      ip_mreq group = {};
+      inet_pton(AF_INET, MESH_GROUP, &group.imr_multiaddr);
+      inet_pton(AF_INET, "127.0.0.1", &group.imr_interface);
+      if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) perror("MESH: join");
+      setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &group.imr_interface, sizeof(group.imr_interface));
+      unsigned char loop = 1;
+      setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+      to = {};
+      to.sin_family = AF_INET;
+      to.sin_port = htons(port);
+      to.sin_addr = group.imr_multiaddr;
+
+      Serial.printf("MESH: node %u on %s:%u\n", nodeId, MESH_GROUP, port);
+      hello();
+    }
+
+    // Own scheduler (bridge)
+    void init(String prefix, String password, uint16_t port = 5555, WiFiMode_t mode = WIFI_AP_STA, 
+              uint8_t channel = 1, uint8_t hidden = 0) {
+      init(prefix, password, &ownScheduler, port, mode, channel, hidden);
+    }
+
+    void stop() {
+      if (fd >= 0) close(fd);
+      fd = -1;
+      nodes.clear();
+    }
+
+    uint32_t getNodeId() { return nodeId; }
+    // Same monotonic clock in every process (hand driven clock in simulations)
+    uint32_t getNodeTime() {
+      if (hostClock.manual) return (uint32_t)(hostClock.us + skewUs);
+      timespec t;
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      return (uint32_t)(t.tv_sec * 1000000ULL + t.tv_nsec / 1000 + skewUs);
+    }
+
+    std::list<uint32_t> getNodeList(bool includeSelf = false) {
+      std::list<uint32_t> list;
+      for (auto& n : nodes) list.push_back(n.first);
+      if (includeSelf) list.push_back(nodeId);
+      return list;
+    }
+
+    bool sendBroadcast(String msg, bool includeSelf = false) {
+      if (includeSelf) self.push_back(msg);
+      return send(MSG_BROADCAST, 0, msg);
+    }
+
+    bool sendSingle(uint32_t dest, String msg) {
+      return send(MSG_SINGLE, dest, msg);
+    }
+
+    void onReceive(std::function<void(uint32_t, String&)> cb) { receiveCallback = cb; }
+    void onChangedConnections(std::function<void()> cb) { changedCallback = cb; }
+    void onNodeTimeAdjusted(std::function<void(int32_t)> cb) { timeCallback = cb; }
+    void onNewConnection(std::function<void(uint32_t)> cb) { newCallback = cb; }
+    void onDroppedConnection(std::function<void(uint32_t)> cb) { droppedCallback = cb; }
+
+    void update()
+    {
+      if (fd >= 0)
+      {
+        uint32_t now = millis();
+        bool changed = false;
+
+        // Receive
+        uint8_t packet[65536];
+        ssize_t n;
+        while ((n = recv(fd, packet, sizeof(packet), 0)) >= 13) 
+        {
+          uint32_t mesh = u32(packet);
+          uint8_t type = packet[4];
+          uint32_t from = u32(packet + 5);
+          uint32_t dest = u32(packet + 9);
+          if (mesh != meshHash || from == nodeId) continue;
+
+          if (!nodes.count(from)) {
+            changed = true;
+            if (newCallback) newCallback(from);
+          }
+          nodes[from] = now;
+
+          if (type == MSG_HELLO || (type == MSG_SINGLE && dest != nodeId)) continue;
+          if (lossPercent && random(100) < lossPercent) continue;
+
+          received++;
+          bytesReceived += n - 13;
+          String msg(std::string((char*)packet + 13, n - 13));
+          if (receiveCallback) receiveCallback(from, msg);
+        }
+
+        // Lost nodes
+        for (auto it = nodes.begin(); it != nodes.end(); ) {
+          if (now - it->second > MESH_LOST_MS) {
+            if (droppedCallback) droppedCallback(it->first);
+            it = nodes.erase(it);
+            changed = true;
+          }
+          else ++it;
+        }
+
+        if (now - helloAt >= MESH_HELLO_MS) hello();
+        if (changed && changedCallback) changedCallback();
+      }
+
+      // Broadcasts to self
+      while (!self.empty()) {
+        String msg = self.front();
+        self.pop_front();
+        if (receiveCallback) receiveCallback(nodeId, msg);
+      }
+
+      if (scheduler) scheduler->execute();
+    }
+
+  private:
+    enum { MSG_HELLO, MSG_BROADCAST, MSG_SINGLE };
+
+    int fd = -1;
+    sockaddr_in to = {};
+    uint32_t nodeId = 0;
+    uint32_t meshHash = 0;
+    int32_t skewUs = 0;
+    int lossPercent = 0;
+    uint32_t helloAt = 0;
+    std::map<uint32_t, uint32_t> nodes;       // node -> last heard (ms)
+    std::list<String> self;
+    Scheduler* scheduler = nullptr;
+    Scheduler ownScheduler;
+
+    std::function<void(uint32_t, String&)> receiveCallback;
+    std::function<void()> changedCallback;
+    std::function<void(int32_t)> timeCallback;
+    std::function<void(uint32_t)> newCallback;
+    std::function<void(uint32_t)> droppedCallback;
+
+    void hello() {
+      helloAt = millis();
+      send(MSG_HELLO, 0, String());
+    }
+
+    bool send(uint8_t type, uint32_t dest, const String& msg) {
+      if (fd < 0) return false;
+      std::string packet(13, 0);
+      put32(&packet[0], meshHash);
+      packet[4] = type;
+      put32(&packet[5], nodeId);
+      put32(&packet[9], dest);
+      packet += msg;
+      if (type != MSG_HELLO) {
+        sent++;
+        bytesSent += msg.length();
+      }
+      return sendto(fd, packet.data(), packet.size(), 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)packet.size();
+    }
+
+    static uint32_t u32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+    static void put32(char* p, uint32_t v) { for (int k=0; k<4; k++) p[k] = v >> (8*k); }
+};
+
+#endif
@@ -0,0 +1,87 @@
+// ARTNET INPUT (artnet.h)
+//   ArtDMX over loopback: slots read up to the declared DMX length and the end of the packet,
+//   packets too short for the patch ignored.
+
+#include <unity.h>
+#include <K32.h>
+#include <WiFiUdp.h>
+#include "artnet.h"
+
+#define TEST_SLOTS 16
+#define TEST_ADDRESS 4
+
+class Anim_test_slots : public K32_anim {
+  public:
+    void draw(int data[ANIM_DATA_SLOTS]) {}
+};
+
+Anim_test_slots anim;
+ArtnetInput* artnet;
+WiFiUDP sender;
+uint8_t sequence = 0;
+
+// ArtDMX universe 0: declared length, then sent bytes of 1, 2, 3...
+void send(int declared, int sent)
+{
+  uint8_t packet[ARTNET_HEADER + 512] = {'A','r','t','-','N','e','t',0, 0x00, 0x50, 0, 14};
+  packet[12] = ++sequence;
+  packet[16] = declared >> 8;
+  packet[17] = declared & 0xFF;
+  for (int i=0; i<sent; i++) packet[ARTNET_HEADER + i] = i+1;
+
+  sender.beginPacket("127.0.0.1", ARTNET_PORT);
+  sender.write(packet, ARTNET_HEADER + sent);
+  sender.endPacket();
+  delay(5);
+  artnet->update();
+}
+
+void clearSlots() {
+  for (int i=0; i<ANIM_DATA_SLOTS; i++) anim.set(i, -2);
+}
+
+void setUp() { clearSlots(); }
+void tearDown() {}
+
+void test_full_packet_fills_patch()
+{
+  send(512, 512);
+  for (int i=0; i<TEST_SLOTS; i++) TEST_ASSERT_EQUAL(TEST_ADDRESS + i + 1, anim.data[i]);
+}
+
+void test_slots_bounded_by_packet_end()
+{
+  send(512, TEST_ADDRESS + 6);
+  for (int i=0; i<6; i++) TEST_ASSERT_EQUAL(TEST_ADDRESS + i + 1, anim.data[i]);
+  for (int i=6; i<TEST_SLOTS; i++) TEST_ASSERT_EQUAL(-2, anim.data[i]);
+}
+
+void test_slots_bounded_by_declared_length()
+{
+  send(TEST_ADDRESS + 3, 512);
+  for (int i=0; i<3; i++) TEST_ASSERT_EQUAL(TEST_ADDRESS + i + 1, anim.data[i]);
+  for (int i=3; i<TEST_SLOTS; i++) TEST_ASSERT_EQUAL(-2, anim.data[i]);
+}
+
+void test_packet_short_of_patch_ignored()
+{
+  uint32_t ignored = artnet->ignored;
+  send(512, TEST_ADDRESS);
+  send(TEST_ADDRESS - 1, 512);
+  send(0, 0);
+  TEST_ASSERT_EQUAL(ignored + 3, artnet->ignored);
+  for (int i=0; i<TEST_SLOTS; i++) TEST_ASSERT_EQUAL(-2, anim.data[i]);
+}
+
+int main(int argc, char** argv)
+{
+  artnet = new ArtnetInput(&anim, 0, TEST_ADDRESS, TEST_SLOTS);
+  artnet->begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_full_packet_fills_patch);
+  RUN_TEST(test_slots_bounded_by_packet_end);
+  RUN_TEST(test_slots_bounded_by_declared_length);
+  RUN_TEST(test_packet_short_of_patch_ignored);
+  return UNITY_END();
+}
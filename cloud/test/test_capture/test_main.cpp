@@ -0,0 +1,237 @@
+// MESH CAPTURE (capture.h)
+//   events come back as recorded, the ring drops the oldest ones when full,
+//   a dump read back is the same capture, replay dispatches at the recorded pace with the recorded mesh time.
+//   Bridge hooks: its critical sends and their resends are captured between the acks received.
+
+#include <unity.h>
+#include "capture.h"
+#include "transport.h"
+#include <vector>
+
+uint32_t meshNow = 0;
+uint32_t meshClock() { return meshNow; }
+
+// Replayed events
+struct Replayed {
+  uint32_t at;            // host µs
+  uint32_t mesh;          // replay mesh time at dispatch
+  CaptureEvent ev;
+  String payload;
+};
+std::vector<Replayed> replayed;
+CaptureRing* replaying = nullptr;
+
+void dispatch(const CaptureEvent& ev, uint8_t* payload) {
+  replayed.push_back({micros(), replaying->replayMillis(), ev, String((char*)payload)});
+}
+
+void setUp() {
+  hostClock.manual = true;
+  hostClock.us = 1000000;
+  meshNow = 50000;
+  replayed.clear();
+}
+void tearDown() {}
+
+// Events of a short session, 10 ms apart
+void session(CaptureRing& ring, int count) {
+  for (int k=0; k<count; k++) {
+    String msg = "M=" + String(k % 10) + "," + String(meshNow);
+    if (k % 3 == 2) {
+      uint8_t ids[8] = {1, 0, 0, 0, 2, 0, 0, 0};
+      ring.record(CAPTURE_TOPOLOGY, 0, 2, ids, 8);
+    }
+    else ring.record(k % 3 ? CAPTURE_SEND : CAPTURE_RECV, 100 + k, msg);
+    hostClock.us += 10000;
+    meshNow += 10;
+  }
+}
+
+void test_events_read_back_as_recorded()
+{
+  CaptureRing ring;
+  ring.clock = meshClock;
+  session(ring, 6);
+
+  size_t pos = 0;
+  CaptureEvent ev;
+  uint8_t payload[CAPTURE_PAYLOAD + 1];
+  for (int k=0; k<6; k++) {
+    TEST_ASSERT_TRUE(ring.read(pos, ev, payload));
+    TEST_ASSERT_EQUAL_UINT32(1000000 + k * 10000, ev.local);
+    TEST_ASSERT_EQUAL_UINT32(50000 + k * 10, ev.mesh);
+    if (k % 3 == 2) {
+      TEST_ASSERT_EQUAL(CAPTURE_TOPOLOGY, ev.type);
+      TEST_ASSERT_EQUAL(2, ev.value);
+      TEST_ASSERT_EQUAL(8, ev.length);
+      TEST_ASSERT_EQUAL(2, payload[4]);
+    }
+    else {
+      TEST_ASSERT_EQUAL(k % 3 ? CAPTURE_SEND : CAPTURE_RECV, ev.type);
+      TEST_ASSERT_EQUAL_UINT32(100 + k, ev.node);
+      payload[ev.length] = 0;
+      TEST_ASSERT_EQUAL_STRING(("M=" + String(k) + "," + String(50000 + k * 10)).c_str(), (char*)payload);
+    }
+  }
+  TEST_ASSERT_FALSE(ring.read(pos, ev, payload));
+}
+
+void test_full_ring_drops_oldest_events()
+{
+  CaptureRing ring(256);
+  ring.clock = meshClock;
+  session(ring, 40);
+
+  TEST_ASSERT_EQUAL_UINT32(40, ring.events);
+  TEST_ASSERT_GREATER_THAN(0, ring.dropped);
+
+  // What is left: the last events, in order, up to the end
+  size_t pos = 0;
+  CaptureEvent ev;
+  uint8_t payload[CAPTURE_PAYLOAD + 1];
+  uint32_t last = 0;
+  int kept = 0;
+  while (ring.read(pos, ev, payload)) {
+    if (kept) TEST_ASSERT_EQUAL_UINT32(last + 10, ev.mesh);
+    last = ev.mesh;
+    kept++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(ring.events - ring.dropped, kept);
+  TEST_ASSERT_EQUAL_UINT32(50000 + 39 * 10, last);
+}
+
+void test_dump_loads_back_as_the_same_capture()
+{
+  CaptureRing ring(512);
+  ring.clock = meshClock;
+  session(ring, 30);                  // wrapped
+
+  std::string dump;
+  Serial.captured = &dump;
+  ring.dump();
+  Serial.captured = nullptr;
+
+  // Node side: "CAPTURE <bytes>" line consumed by the serial handler, then load()
+  TEST_ASSERT_TRUE(dump.rfind("CAPTURE ", 0) == 0);
+  size_t eol = dump.find('\n');
+  int bytes = atoi(dump.c_str() + 8);
+  Serial.input = dump.substr(eol + 1);
+  CaptureRing loaded(512);
+  TEST_ASSERT_TRUE(loaded.load(bytes));
+  Serial.input.clear();
+
+  size_t a = 0, b = 0;
+  CaptureEvent ea, eb;
+  uint8_t pa[CAPTURE_PAYLOAD + 1], pb[CAPTURE_PAYLOAD + 1];
+  int events = 0;
+  while (ring.read(a, ea, pa)) {
+    TEST_ASSERT_TRUE(loaded.read(b, eb, pb));
+    TEST_ASSERT_EQUAL_UINT32(ea.local, eb.local);
+    TEST_ASSERT_EQUAL_UINT32(ea.mesh, eb.mesh);
+    TEST_ASSERT_EQUAL(ea.type, eb.type);
+    TEST_ASSERT_EQUAL_UINT32(ea.node, eb.node);
+    TEST_ASSERT_EQUAL(ea.value, eb.value);
+    TEST_ASSERT_EQUAL(ea.length, eb.length);
+    TEST_ASSERT_EQUAL_MEMORY(pa, pb, ea.length);
+    events++;
+  }
+  TEST_ASSERT_FALSE(loaded.read(b, eb, pb));
+  TEST_ASSERT_GREATER_THAN(0, events);
+}
+
+void test_replay_at_recorded_pace_and_mesh_time()
+{
+  CaptureRing ring;
+  ring.clock = meshClock;
+  session(ring, 9);
+
+  // Later, on another node: replay driven by the host clock, 1 ms steps
+  hostClock.us = 7000000;
+  replaying = &ring;
+  ring.replayStart();
+  TEST_ASSERT_TRUE(ring.replaying);
+  uint32_t start = micros();
+  for (int ms=0; ms<200 && ring.replaying; ms++) {
+    ring.replay(dispatch);
+    hostClock.us += 1000;
+  }
+  replaying = nullptr;
+
+  TEST_ASSERT_FALSE(ring.replaying);
+  TEST_ASSERT_EQUAL(9, replayed.size());
+  for (int k=0; k<9; k++) {
+    TEST_ASSERT_EQUAL_UINT32(start + k * 10000, replayed[k].at);
+    TEST_ASSERT_EQUAL_UINT32(50000 + k * 10, replayed[k].mesh);
+    TEST_ASSERT_EQUAL_UINT32(1000000 + k * 10000, replayed[k].ev.local);
+  }
+  TEST_ASSERT_EQUAL_STRING("M=0,50000", replayed[0].payload.c_str());
+  TEST_ASSERT_EQUAL_STRING("M=1,50010", replayed[1].payload.c_str());
+
+  // Mesh time runs on from the last event
+  hostClock.us += 25000;
+  TEST_ASSERT_EQUAL_UINT32(50000 + 8 * 10 + 25 + 1, ring.replayMillis());
+}
+
+// Bridge send hooks (bridge/src/main.cpp: meshBroadcast / meshSingle)
+CaptureRing* bridgeRing = nullptr;
+void bridgeBroadcast(String& msg, bool includeSelf) { bridgeRing->record(CAPTURE_SEND, 0, msg); }
+void bridgeSingle(uint32_t to, String& msg) { bridgeRing->record(CAPTURE_SEND, to, msg); }
+
+// PLAY to 3 nodes, node 3 misses it: broadcast, 2 acks, resend to node 3 alone, its ack
+void test_bridge_sends_captured()
+{
+  CaptureRing ring;
+  ring.clock = meshClock;
+  bridgeRing = &ring;
+  Transport bridge;
+  bridge.broadcast = bridgeBroadcast;
+  bridge.single = bridgeSingle;
+  bridge.begin(9);
+
+  bridge.sendCritical("TP=60000", {1, 2, 3});
+  size_t pos = 0;
+  CaptureEvent ev;
+  uint8_t payload[CAPTURE_PAYLOAD + 1];
+  TEST_ASSERT_TRUE(ring.read(pos, ev, payload));
+  payload[ev.length] = 0;
+  String wire = (char*)payload;
+  String ackMsg = "ACK=" + wire.substring(1, wire.indexOf(":"));
+
+  for (uint32_t from : {1, 2}) {
+    ring.record(CAPTURE_RECV, from, ackMsg);
+    bridge.receive(from, ackMsg);
+  }
+  hostClock.us += TRANSPORT_RETRY_MS * 1000;
+  bridge.update();
+  ring.record(CAPTURE_RECV, 3, ackMsg);
+  bridge.receive(3, ackMsg);
+  bridge.update();
+  bridgeRing = nullptr;
+
+  struct { uint8_t type; uint32_t node; String msg; } expected[] = {
+    { CAPTURE_SEND, 0, wire }, { CAPTURE_RECV, 1, ackMsg }, { CAPTURE_RECV, 2, ackMsg },
+    { CAPTURE_SEND, 3, wire }, { CAPTURE_RECV, 3, ackMsg }
+  };
+  pos = 0;
+  for (auto& e : expected) {
+    TEST_ASSERT_TRUE(ring.read(pos, ev, payload));
+    payload[ev.length] = 0;
+    TEST_ASSERT_EQUAL(e.type, ev.type);
+    TEST_ASSERT_EQUAL_UINT32(e.node, ev.node);
+    TEST_ASSERT_EQUAL_STRING(e.msg.c_str(), (char*)payload);
+  }
+  TEST_ASSERT_FALSE(ring.read(pos, ev, payload));
+  TEST_ASSERT_TRUE(wire.endsWith(":TP=60000"));
+  TEST_ASSERT_EQUAL(bridge.expected, bridge.delivered);
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_events_read_back_as_recorded);
+  RUN_TEST(test_full_ring_drops_oldest_events);
+  RUN_TEST(test_dump_loads_back_as_the_same_capture);
+  RUN_TEST(test_replay_at_recorded_pace_and_mesh_time);
+  RUN_TEST(test_bridge_sends_captured);
+  return UNITY_END();
+}
@@ -0,0 +1,77 @@
+// COMPOSITOR (compositor.h)
+//   layer stack ports of breath / crawler / rainbow / flash = their handwritten versions,
+//   pixel for pixel, at every size and along the macro time; a full stack drops new layers.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_cloudled.h"
+#include "anim_dmx_strip.h"
+#include "bench.h"
+#include "../bench/handwritten.h"
+
+K32* k32;
+
+void setUp() {}
+void tearDown() {}
+
+void test_ports_match_handwritten_macros()
+{
+  HandPair* pairs = handPairs();
+  int data[ANIM_DATA_SLOTS];
+  static CRGBW ported[3000];
+  static CRGBW hand[3000];
+
+  for (int p=0; p<HAND_PAIRS; p++)
+    for (int size : benchSizes)
+      for (int time=0; time<3000; time+=70)
+      {
+        handFrame(data, time, pairs[p].turn);
+        pairs[p].ported->render(data, ported, size);
+        handFrame(data, time, pairs[p].turn);
+        pairs[p].hand->render(data, hand, size);
+
+        for (int i=0; i<size; i++)
+          if (!(ported[i] == hand[i])) {
+            char msg[80];
+            snprintf(msg, sizeof(msg), "%s size %d time %d pixel %d", pairs[p].name, size, time, i);
+            TEST_FAIL_MESSAGE(msg);
+          }
+      }
+}
+
+// Five layers on a four layers stack
+class Anim_test_stack : public Anim_cloud_layers {
+  public:
+    Layer* added[LAYERS_MAX+1];
+    void compose(int data[ANIM_DATA_SLOTS]) {
+      for (int k=0; k<=LAYERS_MAX; k++) added[k] = this->solid(CRGBW{k*10, 0, 0}, BLEND_MAX);
+    }
+};
+
+void test_full_stack_drops_layer()
+{
+  Anim_test_stack stack;
+  int data[ANIM_DATA_SLOTS] = {0};
+  CRGBW buf[10];
+
+  stack.render(data, buf, 10);
+  for (int k=0; k<LAYERS_MAX; k++) TEST_ASSERT_NOT_NULL(stack.added[k]);
+  TEST_ASSERT_NULL(stack.added[LAYERS_MAX]);
+  TEST_ASSERT_TRUE(stack.overflow);
+  TEST_ASSERT_EQUAL(LAYERS_MAX, stack.layerCount);
+
+  // top layer still the last one accepted
+  TEST_ASSERT_EQUAL((LAYERS_MAX-1)*10, buf[9].r);
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, 3000, LED_WS2812B_V3, 27);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_ports_match_handwritten_macros);
+  RUN_TEST(test_full_stack_drops_layer);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+// DMX BLINK (anim_dmx_strip.h, pulse.h)
+//   blink strobe in WIFI state: each node on its own clock, pulses phased on the DMX frame
+//   setting the blink. Two nodes with unrelated clocks receiving the same frames blink together.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_dmx_strip.h"
+
+#define TEST_SIZE 30
+
+K32* k32;
+Anim_dmx_strip* nodeA;
+Anim_dmx_strip* nodeB;
+CRGBW canvasA[TEST_SIZE];
+CRGBW canvasB[TEST_SIZE];
+
+uint32_t clockA() { return millis() + 123457; }
+uint32_t clockB() { return millis() + 7001; }
+
+void setUp() {}
+void tearDown() {}
+
+void frame(int data[ANIM_DATA_SLOTS], int strobe, int period)
+{
+  for (int k=0; k<ANIM_DATA_SLOTS; k++) data[k] = 0;
+  data[0] = 255;
+  data[1] = 255;
+  data[8] = strobe;
+  data[9] = period;
+  data[15] = 255;
+}
+
+bool lit(const CRGBW* canvas) {
+  return canvas[0].r > 0;
+}
+
+void test_nodes_blink_in_phase()
+{
+  int data[ANIM_DATA_SLOTS];
+  hostClock.manual = true;
+  hostClock.us = 5000000;
+
+  // Same frames on both nodes, blink period changed once on the way
+  int pulses = 0;
+  for (int t=0; t<12000; t+=2)
+  {
+    frame(data, 115, (t < 6000) ? 200 : 120);
+    nodeA->render(data, canvasA);
+    nodeB->render(data, canvasB);
+    TEST_ASSERT_EQUAL_MESSAGE(lit(canvasA), lit(canvasB), "nodes out of phase");
+    if (lit(canvasA)) pulses++;
+    hostClock.us += 2000;
+  }
+  TEST_ASSERT_TRUE(pulses > 0);
+  TEST_ASSERT_TRUE(pulses < 12000/2);
+}
+
+void test_blink_starts_on_setting_frame()
+{
+  int data[ANIM_DATA_SLOTS];
+  frame(data, 0, 0);
+  nodeA->render(data, canvasA);
+
+  frame(data, 115, 200);
+  hostClock.us += 777000;
+  nodeA->render(data, canvasA);
+  TEST_ASSERT_TRUE(lit(canvasA));
+
+  hostClock.us += (STROB_ON_MS + 1) * 1000;
+  nodeA->render(data, canvasA);
+  TEST_ASSERT_FALSE(lit(canvasA));
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, TEST_SIZE, LED_WS2812B_V3, 27);
+  output.master(255);
+
+  nodeA = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(TEST_SIZE)) );
+  nodeB = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(TEST_SIZE)) );
+  nodeA->clock = clockA;
+  nodeB->clock = clockB;
+  light->anim("dmxA", nodeA, TEST_SIZE)->drawTo(strip);
+  light->anim("dmxB", nodeB, TEST_SIZE)->drawTo(strip);
+  nodeA->init();
+  nodeB->init();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_nodes_blink_in_phase);
+  RUN_TEST(test_blink_starts_on_setting_frame);
+  return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// DMX PATTERN KERNELS (anim_dmx_strip.h)
+//   the specialized kernels (color x pix mode) = the generic per pixel pattern they replaced,
+//   bit for bit, over random DMX frames and segments of 1 to 3000 pixels.
+//   referencePattern() is the pattern() of before the kernels, modes without SD sequence.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_dmx_strip.h"
+
+#define TEST_SIZE 3000
+
+void referencePattern(int data[ANIM_DATA_SLOTS], int segmentSize, CRGBW* segment)
+{
+  int pixMode = simplifyDmxRange(data[5]);
+
+  int colorMode = COLOR_BI;
+  if (pixMode == 23) colorMode = COLOR_TRI;
+  else if (pixMode == 24) colorMode = COLOR_QUAD;
+  else if (btw(pixMode, 6, 11)) colorMode = COLOR_PICKER;
+
+  if (colorMode == COLOR_BI)
+  {
+    CRGBW color1 {data[1], data[2], data[3], data[4]};
+    for(int i=0; i<segmentSize; i++) segment[i] = color1;
+  }
+  else if (colorMode == COLOR_PICKER)
+  {
+    int hueStart = data[10] + data[7];
+    int hueEnd = data[11] + data[7];
+    CRGBW rgbwMaster {data[1], data[2], data[3], data[4]};
+    CRGBW colorWheel;
+    for(int i=0; i<segmentSize; i++) {
+      segment[i] = colorWheel.setHue( (hueStart + ((hueEnd - hueStart) * i) / segmentSize) );
+      segment[i] %= rgbwMaster;
+    }
+  }
+  else
+  {
+    CRGBW color[5] = {
+      {data[10], data[11], data[12], data[13]},
+      colorPresetDmx[ simplifyDmxRange(data[1]) ],
+      colorPresetDmx[ simplifyDmxRange(data[2]) ],
+      colorPresetDmx[ simplifyDmxRange(data[3]) ],
+      colorPresetDmx[ simplifyDmxRange(data[4]) ]
+    };
+    int dashLength  = max(3, scale255(2 * segmentSize, data[6]));
+    int dashOffset  = scale255((segmentSize-dashLength), data[7]);
+    int dashSplit = (colorMode == COLOR_QUAD) ? 4 : 3;
+    for(int i=0; i<segmentSize; i++) {
+      int dashPart = (i-dashOffset)*dashSplit/dashLength + 1;
+      if (dashPart < 0 || dashPart > dashSplit) dashPart = 0;
+      segment[i] = color[ dashPart ];
+    }
+    return;
+  }
+
+  CRGBW backColor {CRGBW::Black};
+  if (colorMode == COLOR_BI) backColor = CRGBW{data[10], data[11], data[12], data[13]};
+
+  int dashLength  = max(1, scale255(segmentSize, data[6]) );
+  int dashOffset  =  scale255(segmentSize+2*dashLength, data[7])-dashLength;
+
+  if (pixMode == 1 || pixMode == 7) {
+    for(int i=dashLength; i<segmentSize+dashLength; i++)
+      if (i < dashOffset || i >= dashOffset+dashLength) segment[i-dashLength] = backColor;
+  }
+
+  if (pixMode == 2 || pixMode == 8) {
+    dashLength = max(1, data[6]);
+    for(int i=0; i<segmentSize; i++)
+      if ( (i+dashOffset)/dashLength % 2 == 1 ) segment[i] = backColor;
+  }
+  else if (pixMode == 3 || pixMode == 9) {
+    for(int i=0; i<segmentSize; i++) {
+      if (i >= dashOffset && i < dashOffset+dashLength) {
+        int coef = (dashLength>1) ? ((dashOffset+dashLength-1-i) * 255 ) / (dashLength-1) : 0;
+        segment[i] %= (uint8_t)coef;
+        segment[i] += backColor % (uint8_t)(255-coef);
+      }
+      else segment[i] = backColor;
+    }
+  }
+  else if (pixMode == 4 || pixMode == 10) {
+    for(int i=0; i<segmentSize; i++) {
+      if (i >= dashOffset && i < dashOffset+dashLength) {
+        int coef = (dashLength>1) ? ((i-dashOffset) * 255 ) / (dashLength-1) : 0;
+        segment[i] %= (uint8_t)coef;
+        segment[i] += backColor % (uint8_t)(255-coef);
+      }
+      else segment[i] = backColor;
+    }
+  }
+  else if (pixMode == 5 || pixMode == 11) {
+    for(int i=0; i<segmentSize; i++) {
+      if (i >= dashOffset && i < dashOffset+dashLength/2) {
+        int coef = (dashLength>1) ? ((i-dashOffset) * 255 ) / (dashLength/2) : 0;
+        segment[i] %= (uint8_t)coef;
+        segment[i] += backColor % (uint8_t)(255-coef);
+      }
+      else if (i >= dashOffset+dashLength/2 && i < dashOffset+dashLength) {
+        int coef = (dashLength>1) ? ((dashOffset+dashLength-1-i) * 255 ) / (dashLength/2) : 0;
+        segment[i] %= (uint8_t)coef;
+        segment[i] += backColor % (uint8_t)(255-coef);
+      }
+      else segment[i] = backColor;
+    }
+  }
+}
+
+K32* k32;
+Anim_dmx_strip* dmx;
+
+void setUp() {}
+void tearDown() {}
+
+// Pix modes of the reference: 0-11 (BI, PICKER), 18-22 (BI, plain), 23-24 (TRI, QUAD)
+void test_kernels_match_reference()
+{
+  const int modes[] = {0,1,2,3,4,5,6,7,8,9,10,11,18,19,20,21,22,23,24};
+  const int sizes[] = {1, 2, 3, 5, 7, 25, 150, 750, 3000};
+  static CRGBW expected[TEST_SIZE];
+  char msg[120];
+
+  randomSeed(31);
+  for (int mode : modes)
+    for (int size : sizes)
+      for (int iter=0; iter<200; iter++)
+      {
+        int data[ANIM_DATA_SLOTS] = {0};
+        for (int k=0; k<16; k++) data[k] = random(256);
+        data[5] = mode * 10 + 1;
+        if (iter % 3 == 0) data[6] = random(4);               // short dashes
+        if (iter % 5 == 0) data[7] = (iter % 2) ? 0 : 255;    // offset ends
+
+        int segment = 1 + random(size);
+        referencePattern(data, segment, expected);
+        dmx->pattern(data, segment);
+
+        for (int i=0; i<segment; i++)
+          if (!(dmx->patternBuf[i] == expected[i])) {
+            snprintf(msg, sizeof(msg), "pix mode %d segment %d pixel %d (length %d offset %d)", mode, segment, i, data[6], data[7]);
+            TEST_FAIL_MESSAGE(msg);
+          }
+      }
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, TEST_SIZE, LED_WS2815_V1, 22);
+  dmx = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(TEST_SIZE)) );
+  light->anim("dmx", dmx, TEST_SIZE)->drawTo(strip);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_kernels_match_reference);
+  return UNITY_END();
+}
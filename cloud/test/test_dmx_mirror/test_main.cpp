@@ -0,0 +1,137 @@
+// DMX MIRROR & ZOOM (anim_dmx_strip.h)
+//   segment copies (blit / blitReversed) + cleared margins = the per pixel mirror of before:
+//   pixel i of the zoom window shows segment[i % segment], read backward on alternate copies.
+//   Every mirror mode and zoom value, on a canvas (render) and on the strip, from dirty pixels.
+//   A too small arena draws nothing.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_dmx_strip.h"
+
+#define TEST_SIZE 750
+
+const int sizes[] = {1, 2, 3, 7, 25, 150, 750};
+#define SIZES 7
+
+K32* k32;
+Anim_dmx_strip* dmx[SIZES];
+CRGBW expected[TEST_SIZE];
+CRGBW canvas[TEST_SIZE];
+
+void setUp() {}
+void tearDown() {}
+
+// Reference: strip cleared, then every pixel of the zoom window looked up in the segment
+void referenceMirror(int data[ANIM_DATA_SLOTS], int size, const CRGBW* segment)
+{
+  int mirrorMode  = simplifyDmxRange(data[14]);
+  int zoomedSize  = max(1, scale255( size, data[15]) );
+
+  int segmentSize = zoomedSize;
+  if (mirrorMode == 1 || mirrorMode == 4)       segmentSize /= 2;
+  else if (mirrorMode == 2 || mirrorMode == 5)  segmentSize /= 3;
+  else if (mirrorMode == 3 || mirrorMode == 6)  segmentSize /= 4;
+  if (segmentSize<1) segmentSize = 1;
+
+  int mirrorAlternate = 1 + btw(mirrorMode, 1, 3);
+  int zoomOffset = (size - zoomedSize)/2;
+
+  for (int i=0; i<size; i++) expected[i] = CRGBW{CRGBW::Black};
+  for (int i=0; i<zoomedSize; i++) {
+    int pix  = i % segmentSize;
+    int iter = i / segmentSize;
+    if (iter && iter % mirrorAlternate) pix = segmentSize - pix - 1;
+    expected[i+zoomOffset] = segment[pix];
+  }
+}
+
+// Pattern varying along the segment: picker hue ramp, full master, no strobe
+void frame(int data[ANIM_DATA_SLOTS], int mirror, int zoom)
+{
+  for (int k=0; k<ANIM_DATA_SLOTS; k++) data[k] = 0;
+  data[0] = 255;
+  data[1] = data[2] = data[3] = 255;
+  data[5] = 61;           // picker
+  data[11] = 255;         // hue end
+  data[14] = mirror;
+  data[15] = zoom;
+}
+
+void check(const char* target, int size, int mirror, int zoom, const CRGBW* pixels)
+{
+  for (int i=0; i<size; i++)
+    if (!(pixels[i] == expected[i])) {
+      char msg[100];
+      snprintf(msg, sizeof(msg), "%s size %d mirror %d zoom %d pixel %d", target, size, mirror, zoom, i);
+      TEST_FAIL_MESSAGE(msg);
+    }
+}
+
+void test_mirror_zoom_on_canvas()
+{
+  int data[ANIM_DATA_SLOTS];
+  for (int s=0; s<SIZES; s++)
+    for (int mirror=0; mirror<256; mirror++)
+      for (int zoom=0; zoom<256; zoom++)
+      {
+        if (mirror % 10 != 1 && sizes[s] > 25) continue;    // all values on small strips, one per mode above
+        frame(data, mirror, zoom);
+        for (int i=0; i<sizes[s]; i++) canvas[i] = CRGBW{1, 2, 3, 4};
+        dmx[s]->render(data, canvas);
+        referenceMirror(data, sizes[s], dmx[s]->patternBuf);
+        check("canvas", sizes[s], mirror, zoom, canvas);
+      }
+}
+
+void test_mirror_zoom_on_strip()
+{
+  int data[ANIM_DATA_SLOTS];
+  const CRGBW* pixels = ((K32_fixture*)strip)->pixels();
+  for (int s=0; s<SIZES; s++)
+    for (int mirror=1; mirror<256; mirror+=10)
+      for (int zoom=0; zoom<256; zoom++)
+      {
+        frame(data, mirror, zoom);
+        for (int i=0; i<TEST_SIZE; i++) strip->pix(i, CRGBW{5, 6, 7, 8});
+        dmx[s]->draw(data);
+        referenceMirror(data, sizes[s], dmx[s]->patternBuf);
+        check("strip", sizes[s], mirror, zoom, pixels);
+      }
+}
+
+// Arena smaller than arenaBytes(): overflow logged, strip left as is
+void test_small_arena_draws_nothing()
+{
+  Anim_dmx_strip small( new ScratchArena(Anim_dmx_strip::arenaBytes(10)) );
+  light->anim("dmx_small", &small, 150)->drawTo(strip);
+  small.init();
+
+  int data[ANIM_DATA_SLOTS];
+  frame(data, 1, 255);
+  for (int i=0; i<TEST_SIZE; i++) strip->pix(i, CRGBW{5, 6, 7, 8});
+  small.draw(data);
+
+  const CRGBW* pixels = ((K32_fixture*)strip)->pixels();
+  for (int i=0; i<150; i++) TEST_ASSERT_TRUE(pixels[i] == (CRGBW{5, 6, 7, 8}));
+  TEST_ASSERT_NULL(small.patternBuf);
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, TEST_SIZE, LED_WS2815_V1, 22);
+  output.master(255);
+  for (int s=0; s<SIZES; s++) {
+    dmx[s] = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(sizes[s])) );
+    light->anim("dmx_"+String(sizes[s]), dmx[s], sizes[s])->drawTo(strip);
+    dmx[s]->masterLUT.gamma(1.0f);    // linear: segment = pattern
+    dmx[s]->init();
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_mirror_zoom_on_canvas);
+  RUN_TEST(test_mirror_zoom_on_strip);
+  RUN_TEST(test_small_arena_draws_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,96 @@
+// DMX MODULATORS (anim_dmx_strip.h)
+//   strobe / smooth reconfigured on the frame that changes their slots, even at master 0,
+//   'dmx mod redraw' counts the draws where only the modulated master moved.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_dmx_strip.h"
+
+#define TEST_SIZE 30
+
+K32* k32;
+Anim_dmx_strip* dmx;
+CRGBW canvas[TEST_SIZE];
+
+void frame(int data[ANIM_DATA_SLOTS], int master, int strobe, int period)
+{
+  for (int k=0; k<ANIM_DATA_SLOTS; k++) data[k] = 0;
+  data[0] = master;
+  data[1] = 255;
+  data[8] = strobe;
+  data[9] = period;
+  data[15] = 255;
+}
+
+void setUp() {
+  int data[ANIM_DATA_SLOTS];
+  dmx->init();
+  frame(data, 255, 0, 0);
+  dmx->render(data, canvas);
+  dmx->modProbe.reset();
+}
+void tearDown() {}
+
+void test_strobe_set_at_master_zero()
+{
+  int data[ANIM_DATA_SLOTS];
+  frame(data, 0, 15, 100);
+  dmx->render(data, canvas);
+  TEST_ASSERT_TRUE(dmx->strobe->isPlaying());
+
+  frame(data, 0, 25, 100);
+  dmx->render(data, canvas);
+  TEST_ASSERT_FALSE(dmx->strobe->isPlaying());
+  TEST_ASSERT_TRUE(dmx->smooth->isPlaying());
+
+  frame(data, 0, 0, 100);
+  dmx->render(data, canvas);
+  TEST_ASSERT_FALSE(dmx->smooth->isPlaying());
+}
+
+void test_mod_redraw_counts_master_only_changes()
+{
+  int data[ANIM_DATA_SLOTS];
+
+  // strobe set: reconfiguration, not a mod redraw
+  frame(data, 255, 15, 100);
+  dmx->render(data, canvas);
+  TEST_ASSERT_EQUAL(0, dmx->modProbe.count);
+
+  // master moved by the modulator: off and on phases
+  frame(data, 0, 15, 100);
+  dmx->render(data, canvas);
+  frame(data, 255, 15, 100);
+  dmx->render(data, canvas);
+  TEST_ASSERT_EQUAL(2, dmx->modProbe.count);
+
+  // new console frame: not a mod redraw
+  frame(data, 255, 15, 100);
+  data[1] = 10;
+  dmx->render(data, canvas);
+  TEST_ASSERT_EQUAL(2, dmx->modProbe.count);
+}
+
+void test_master_zero_without_modulator_not_counted()
+{
+  int data[ANIM_DATA_SLOTS];
+  frame(data, 0, 0, 0);
+  dmx->render(data, canvas);
+  dmx->render(data, canvas);
+  TEST_ASSERT_EQUAL(0, dmx->modProbe.count);
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, TEST_SIZE, LED_WS2812B_V3, 27);
+  dmx = new Anim_dmx_strip( new ScratchArena(Anim_dmx_strip::arenaBytes(TEST_SIZE)) );
+  light->anim("dmx", dmx, TEST_SIZE)->drawTo(strip);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_strobe_set_at_master_zero);
+  RUN_TEST(test_mod_redraw_counts_master_only_changes);
+  RUN_TEST(test_master_zero_without_modulator_not_counted);
+  return UNITY_END();
+}
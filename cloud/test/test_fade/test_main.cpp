@@ -0,0 +1,134 @@
+// MACRO FADE (light.h)
+//   cross-fade pixels = fixed-point blend of the outgoing / incoming frames,
+//   the incoming macro takes over the strip at the end without prepare() nor redraw.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_cloudled.h"
+
+#define TEST_SIZE 60
+
+// Level ramp along the macro time
+class Anim_test_ramp : public Anim_cloud {
+  public:
+    void draw(int data[ANIM_DATA_SLOTS]) {
+      int level = data[1] * 255 / data[0];
+      for (int i=0; i<this->size(); i++) this->pixel(i, CRGBW{level, i*4, 255-level, i});
+    }
+};
+
+// Stateful: color picked in prepare(), drawn only on a new target
+class Anim_test_still : public Anim_cloud {
+  public:
+    CRGBW color;
+    int prepared = 0;
+    int redraws = 0;
+
+    void prepare() {
+      color = CRGBW{(int)random(256), (int)random(256), (int)random(256), 0};
+      prepared++;
+    }
+
+    void draw(int data[ANIM_DATA_SLOTS]) {
+      if (!this->retargeted) return;
+      this->all(color);
+      this->retargeted = false;
+      redraws++;
+    }
+};
+
+K32* k32;
+Anim_test_ramp* ramp;
+Anim_test_still* still;
+
+const CRGBW* stripPixels() {
+  return ((K32_fixture*)strip)->pixels();
+}
+
+void frameAt(uint32_t now) {
+  updateMacro(now, 0, 1);
+  light->update();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_blend_is_fixed_point_mix_of_both_frames()
+{
+  stopMacro();
+  setActiveMacro(0, 0);
+  frameAt(0);
+  setActiveMacro(1000, 1);
+
+  for (uint32_t t=1000; t<1000+MACRO_FADE_MS; t+=50) {
+    frameAt(t);
+    TEST_ASSERT_TRUE(fadeFrom == 0);
+    int alpha = (t - 1000) * 256 / MACRO_FADE_MS;
+    for (int i=0; i<TEST_SIZE; i++) {
+      const CRGBW& a = fade->bufFrom[i];
+      const CRGBW& b = fade->bufTo[i];
+      TEST_ASSERT_EQUAL((a.r*(256-alpha) + b.r*alpha) >> 8, stripPixels()[i].r);
+      TEST_ASSERT_EQUAL((a.g*(256-alpha) + b.g*alpha) >> 8, stripPixels()[i].g);
+      TEST_ASSERT_EQUAL((a.b*(256-alpha) + b.b*alpha) >> 8, stripPixels()[i].b);
+      TEST_ASSERT_EQUAL((a.w*(256-alpha) + b.w*alpha) >> 8, stripPixels()[i].w);
+    }
+  }
+}
+
+void test_incoming_macro_takes_over_without_jump()
+{
+  stopMacro();
+  setActiveMacro(0, 0);
+  frameAt(0);
+  setActiveMacro(2000, 1);
+  int redraws = still->redraws;
+  frameAt(2000);
+  int prepared = still->prepared;
+  CRGBW color = still->color;
+
+  for (uint32_t t=2000; t<=2000+2*MACRO_FADE_MS; t+=20) frameAt(t);
+
+  TEST_ASSERT_TRUE(fadeFrom == -1);
+  TEST_ASSERT_EQUAL(prepared, still->prepared);
+  TEST_ASSERT_EQUAL(redraws + 1, still->redraws);  // once into the fade buffer, never again
+  TEST_ASSERT_TRUE(still->color == color);
+  for (int i=0; i<TEST_SIZE; i++) TEST_ASSERT_TRUE(stripPixels()[i] == color);
+}
+
+// Wind (noise field of the show time) fading in: no step at the end of the fade
+void test_wind_continuous_through_fade_end()
+{
+  stopMacro();
+  setActiveMacro(0, 1);
+  frameAt(0);
+  setActiveMacro(3000, 2);
+
+  CRGBW last[TEST_SIZE];
+  int step = 0;
+  for (uint32_t t=3000; t<=3000+2*MACRO_FADE_MS; t+=20) {
+    frameAt(t);
+    if (t > 3000 + MACRO_FADE_MS - 100)
+      for (int i=0; i<TEST_SIZE; i++)
+        step = max(step, max(abs(stripPixels()[i].g - last[i].g), abs(stripPixels()[i].r - last[i].r)));
+    for (int i=0; i<TEST_SIZE; i++) last[i] = stripPixels()[i];
+  }
+  TEST_ASSERT_TRUE(fadeFrom == -1);
+  TEST_ASSERT_LESS_THAN(12, step);
+}
+
+int main(int argc, char** argv)
+{
+  k32 = new K32();
+  lightSetup(k32, TEST_SIZE, LED_WS2812B_V3, 27);
+  output.gamma(1.0f);           // linear: strip pixels are the blended ones
+  addMacro(ramp = new Anim_test_ramp, 1000);
+  addMacro(still = new Anim_test_still, 1000);
+  addMacro(new Anim_cloud_wind, 3000);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_blend_is_fixed_point_mix_of_both_frames);
+  RUN_TEST(test_incoming_macro_takes_over_without_jump);
+  RUN_TEST(test_wind_continuous_through_fade_end);
+  return UNITY_END();
+}
@@ -0,0 +1,183 @@
+// FIRMWARE SHARE (firmware.h) over a lossy mesh
+//   20 nodes (more than FW_PEERS), node 0 runs v3, the others v2: every node stages the same
+//   image and boots it, none before the whole fleet reported it complete. A node of the mesh
+//   that never reported holds the switch, until it says FH=0 (bridge), and so does a node
+//   still staging, whatever the node count.
+
+#include <unity.h>
+#include <Preferences.h>
+#include "firmware.h"
+#include <deque>
+#include <vector>
+
+#define NODES   20
+#define IMAGE   (40 * FW_CHUNK + 100)
+#define BRIDGE  9999
+
+struct Wire {
+  int to;
+  uint32_t from;
+  String msg;
+  uint32_t at;
+};
+
+HostOta boards[NODES];
+FirmwareShare* shares[NODES];
+bool booted[NODES];
+bool restarting[NODES];
+bool early = false;                 // a node booted before every node was complete
+std::vector<uint8_t> oldImage, newImage;
+std::deque<Wire> air;
+int current = 0;
+int loss = 10;
+int extra = 0;                      // more nodes in the mesh list: 2000..
+
+uint32_t id(int i) { return 1000 + i; }
+
+// Node i is the current board
+void select(int i) {
+  current = i;
+  hostOtaBoard() = &boards[i];
+  Preferences::scope() = "node" + std::to_string(i);
+}
+
+void broadcast(String& msg, bool includeSelf) {
+  for (int i=0; i<NODES; i++)
+    if (i != current) air.push_back({i, id(current), msg, millis() + 5 + (uint32_t)random(30)});
+}
+void single(uint32_t to, String& msg) {
+  if (to >= id(0) && to < id(NODES)) air.push_back({(int)(to - id(0)), id(current), msg, millis() + 5 + (uint32_t)random(30)});
+}
+
+// ESP.restart() from update(): rebooted into the staged image after it
+void restart() {
+  restarting[current] = true;
+  for (int i=1; i<NODES; i++) early |= !(booted[i] || shares[i]->complete);
+}
+
+void reboot(int i) {
+  select(i);
+  restarting[i] = false;
+  booted[i] = true;
+  boards[i].running = boards[i].boot;
+  delete shares[i];
+  shares[i] = new FirmwareShare();
+  shares[i]->begin(3);
+}
+
+std::list<uint32_t> others(int i, bool bridge) {
+  std::list<uint32_t> list;
+  for (int k=0; k<NODES; k++) if (k != i) list.push_back(id(k));
+  if (bridge) list.push_back(BRIDGE);
+  for (int k=0; k<extra; k++) list.push_back(2000 + k);
+  return list;
+}
+
+// ms steps: deliver what is due (lost at loss %), update every 100 ms
+void run(uint32_t ms, bool bridge) {
+  for (uint32_t t=0; t<ms; t++) {
+    for (size_t k=0; k<air.size(); ) {
+      if (air[k].at > millis()) { k++; continue; }
+      Wire w = air[k];
+      air.erase(air.begin() + k);
+      if (random(100) < loss) continue;
+      select(w.to);
+      shares[w.to]->receive(w.from, w.msg);
+    }
+    if (millis() % 100 == 0)
+      for (int i=0; i<NODES; i++) {
+        select(i);
+        shares[i]->update(others(i, bridge));
+        if (restarting[i]) reboot(i);
+      }
+    hostClock.us += 1000;
+  }
+}
+
+void setUp() {
+  hostClock.manual = true;
+  hostClock.us = 1000000;
+  randomSeed(2);
+  Preferences::store().clear();
+  air.clear();
+  early = false;
+  extra = 0;
+
+  oldImage.resize(IMAGE);
+  newImage.resize(IMAGE);
+  for (int i=0; i<IMAGE; i++) { oldImage[i] = random(256); newImage[i] = random(256); }
+
+  transport.broadcast = broadcast;
+  transport.single = single;
+  ESP.onRestart = restart;
+  ESP.sketchSize = IMAGE;
+  for (int i=0; i<NODES; i++) {
+    select(i);
+    boards[i].running = boards[i].boot = 0;
+    memcpy(boards[i].slots[0]->data, (i == 0 ? newImage : oldImage).data(), IMAGE);
+    memset(boards[i].slots[1]->data, 0xff, HOST_OTA_SIZE);
+    booted[i] = restarting[i] = false;
+    shares[i] = new FirmwareShare();
+    shares[i]->begin(i == 0 ? 3 : 2);
+  }
+}
+
+void tearDown() {
+  for (int i=0; i<NODES; i++) delete shares[i];
+  ESP.onRestart = nullptr;
+}
+
+void test_fleet_stages_and_boots() {
+  run(600000, false);
+  for (int i=1; i<NODES; i++) {
+    TEST_ASSERT_TRUE(booted[i]);
+    TEST_ASSERT_EQUAL(1, boards[i].running);
+    TEST_ASSERT_EQUAL_MEMORY(newImage.data(), boards[i].slots[1]->data, IMAGE);
+    TEST_ASSERT_EQUAL_HEX32(shares[0]->hash, shares[i]->hash);
+  }
+  TEST_ASSERT_FALSE(early);
+}
+
+void test_silent_node_holds_switch() {
+  run(600000, true);
+  for (int i=1; i<NODES; i++) {
+    TEST_ASSERT_TRUE(shares[i]->complete);
+    TEST_ASSERT_FALSE(booted[i]);
+  }
+
+  // Bridge: FH=0
+  for (int i=0; i<NODES; i++) air.push_back({i, BRIDGE, "FH=0", millis()});
+  loss = 0;
+  run(FW_SWITCH_MS + 1000, true);
+  loss = 10;
+  for (int i=1; i<NODES; i++) TEST_ASSERT_TRUE(booted[i]);
+  TEST_ASSERT_FALSE(early);
+}
+
+// Node 2000 still staging, heard first: the 19 others don't push it out of the fleet status
+void test_fleet_beyond_peers() {
+  String staging = "FH=3," + String(IMAGE) + "," + String(shares[0]->hash, HEX) + ",0,AAAAAAAA";
+  extra = 1;
+  for (int i=0; i<NODES; i++) air.push_back({i, 2000, staging, millis()});
+  run(600000, false);
+  for (int i=1; i<NODES; i++) {
+    TEST_ASSERT_TRUE(shares[i]->complete);
+    TEST_ASSERT_FALSE(booted[i]);
+  }
+
+  String complete = "FH=3," + String(IMAGE) + "," + String(shares[0]->hash, HEX) + "," + String(shares[1]->chunks) + ",*";
+  for (int i=0; i<NODES; i++) air.push_back({i, 2000, complete, millis()});
+  loss = 0;
+  run(FW_SWITCH_MS + 1000, false);
+  loss = 10;
+  for (int i=1; i<NODES; i++) TEST_ASSERT_TRUE(booted[i]);
+  TEST_ASSERT_FALSE(early);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fleet_stages_and_boots);
+  RUN_TEST(test_silent_node_holds_switch);
+  RUN_TEST(test_fleet_beyond_peers);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+// FRAME SEQUENCES (frames.h)
+//   raw and RLE sequences decoded as encoded (file mapped on host, flash partition),
+//   sequences whose frames or RLE offsets point past the mapped size refused.
+
+#include <unity.h>
+#include <Arduino.h>
+#include <K32_light.h>
+#include "frames.h"
+#include "../bench/sequence.h"
+
+#define TEST_PIXELS 120
+#define TEST_FRAMES 12
+
+CRGBW bands(int frame, int pixel) { return ((pixel + 3*frame) / 7) % 2 ? CRGBW{255, 40, 0, 9} : CRGBW{0, 0, 80, 1}; }
+
+void setUp() {}
+void tearDown() {}
+
+void checkRows(FrameSequence& seq, int channels)
+{
+  CRGBW row[TEST_PIXELS];
+  for (int f=0; f<TEST_FRAMES; f++) {
+    seq.row(f, row, TEST_PIXELS);
+    for (int i=0; i<TEST_PIXELS; i++) {
+      CRGBW c = bands(f, i);
+      if (channels == 3) c.w = 0;
+      TEST_ASSERT_TRUE(row[i] == c);
+    }
+  }
+}
+
+void test_raw_and_rle_files_decode()
+{
+  for (int rle=0; rle<2; rle++)
+    for (int channels=3; channels<=4; channels++)
+    {
+      const char* path = "/tmp/cloud_test_frames.cldf";
+      TEST_ASSERT_TRUE(sequenceSave(path, sequenceEncode(TEST_PIXELS, TEST_FRAMES, channels, rle, 25, bands)));
+      FrameSequence seq;
+      TEST_ASSERT_TRUE(seq.openFile(path));
+      TEST_ASSERT_EQUAL(rle, seq.rle);
+      checkRows(seq, channels);
+    }
+}
+
+void test_partition_decodes()
+{
+  std::vector<uint8_t> blob = sequenceEncode(TEST_PIXELS, TEST_FRAMES, 4, true, 25, bands);
+  esp_partition_t* part = hostPartition(FRAMES_PARTITION, 64 * 1024);
+  esp_partition_write(part, 0, blob.data(), blob.size());
+
+  FrameSequence seq;
+  TEST_ASSERT_TRUE(seq.openPartition());
+  checkRows(seq, 4);
+}
+
+void test_out_of_bounds_refused()
+{
+  FrameSequence seq;
+
+  // raw frames past the end
+  std::vector<uint8_t> raw = sequenceEncode(TEST_PIXELS, TEST_FRAMES, 3, false, 25, bands);
+  TEST_ASSERT_TRUE(seq.open(raw.data(), raw.size()));
+  TEST_ASSERT_FALSE(seq.open(raw.data(), raw.size() - 1));
+
+  // frame count overflowing the offset table
+  std::vector<uint8_t> rle = sequenceEncode(TEST_PIXELS, TEST_FRAMES, 3, true, 25, bands);
+  TEST_ASSERT_TRUE(seq.open(rle.data(), rle.size()));
+  std::vector<uint8_t> big = rle;
+  big[12] = big[13] = big[14] = big[15] = 0xff;
+  TEST_ASSERT_FALSE(seq.open(big.data(), big.size()));
+
+  // RLE offset past the runs
+  std::vector<uint8_t> bad = rle;
+  bad[FRAMES_HEADER + 4*5 + 3] = 0x7f;
+  TEST_ASSERT_FALSE(seq.open(bad.data(), bad.size()));
+
+  // truncated runs: last frame read up to the end, no further
+  size_t cut = rle.size() - 4;
+  TEST_ASSERT_TRUE(seq.open(rle.data(), cut));
+  CRGBW row[TEST_PIXELS];
+  seq.row(TEST_FRAMES - 1, row, TEST_PIXELS);
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_raw_and_rle_files_decode);
+  RUN_TEST(test_partition_decodes);
+  RUN_TEST(test_out_of_bounds_refused);
+  return UNITY_END();
+}
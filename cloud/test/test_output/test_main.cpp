@@ -0,0 +1,69 @@
+// OUTPUT STAGE (output.h)
+//   gamma OUTPUT_GAMMA by default, master multiply = rounded v * master / 255 for every value, after the gamma table,
+//   white extraction switched on by lightSetup() for RGBW strips only.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_default_gamma()
+{
+  OutputLUT stage;
+  TEST_ASSERT_FALSE(stage.linear);
+  TEST_ASSERT_EQUAL(0, stage.apply(CRGBW{0, 0, 0, 0}).r);
+  TEST_ASSERT_EQUAL(255, stage.apply(CRGBW{255, 0, 0, 0}).r);
+  TEST_ASSERT_EQUAL(56, stage.apply(CRGBW{128, 0, 0, 0}).r);     // 255 * 0.5^2.2
+}
+
+void test_master_is_rounded_scale_of_every_value()
+{
+  OutputLUT stage(1.0f);
+  for (int m=0; m<256; m++) {
+    stage.master(m);
+    for (int v=0; v<256; v++)
+      TEST_ASSERT_EQUAL((v * m + 127) / 255, stage.apply(CRGBW{v, v, v, v}).r);
+  }
+}
+
+void test_master_applies_after_gamma()
+{
+  OutputLUT stage(2.2f);
+  TEST_ASSERT_FALSE(stage.linear);
+  stage.master(128);
+  for (int v=0; v<256; v++) {
+    int g = (int)(255.0f * powf(v/255.0f, 2.2f) + 0.5f);
+    TEST_ASSERT_EQUAL((g * 128 + 127) / 255, stage.apply(CRGBW{0, v, 0, 0}).g);
+  }
+}
+
+void test_white_extraction_on_rgbw_strips()
+{
+  K32* k32 = new K32();
+  lightSetup(k32, 25, LED_SK6812W_V1, 27);
+  TEST_ASSERT_TRUE(output.rgbw);
+  output.gamma(1.0f);
+  output.master(255);
+  CRGBW c = output.apply(CRGBW{200, 120, 90, 10});
+  TEST_ASSERT_EQUAL(110, c.r);
+  TEST_ASSERT_EQUAL(30, c.g);
+  TEST_ASSERT_EQUAL(0, c.b);
+  TEST_ASSERT_EQUAL(100, c.w);
+
+  output.gamma(OUTPUT_GAMMA);
+  output.whiteExtract(false);
+  lightSetup(k32, 25, LED_WS2812B_V3, 27);
+  TEST_ASSERT_FALSE(output.rgbw);
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_default_gamma);
+  RUN_TEST(test_master_is_rounded_scale_of_every_value);
+  RUN_TEST(test_master_applies_after_gamma);
+  RUN_TEST(test_white_extraction_on_rgbw_strips);
+  return UNITY_END();
+}
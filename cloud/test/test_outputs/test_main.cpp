@@ -0,0 +1,114 @@
+// PARALLEL OUTPUTS (outputs.h, light.h)
+//   the logical strip maps one to one onto the outputs, in order (serpentine: odd outputs reversed),
+//   a macro drawn through the map is the single strip frame, library anims and clears cover every output.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_cloudled.h"
+#include <vector>
+
+const int pins[OUTPUTS_MAX] = {22, 21, 19, 18, 5, 17, 16, 4};
+
+void setUp() {}
+void tearDown() {}
+
+// Logical pixel as lit on its output
+CRGBW lit(int i) {
+  if (!outputs) return strip->pixels()[i];
+  return outputs->strips[outputs->which[i]]->pixels()[outputs->index[i]];
+}
+
+// Fresh light: count outputs, one rainbow macro
+void setupLight(int size, int count, bool serpentine) {
+  outputs = nullptr;
+  lightSetup(new K32(), size, LED_WS2815_V1, pins, count, serpentine);
+  macroCount = 0;
+  macro = -1;
+  macroPlaying = -1;
+  fadeFrom = -1;
+  addMacro(new Anim_cloud_rainbow, 3000);
+  setActiveMacro(0, 0);
+}
+
+void test_remap_is_one_to_one_in_output_order()
+{
+  for (int count=2; count<=OUTPUTS_MAX; count++)
+    for (int size=1; size<=800; size++)
+      for (int serpentine=0; serpentine<2; serpentine++)
+      {
+        int length = (size + count - 1) / count;
+        StripMap map;
+        std::vector<K32_fixture> fixtures(count);
+        for (int k=0; k<count; k++) {
+          int part = min(length, size - k*length);
+          if (part <= 0) break;
+          map.add(&fixtures[k], part, serpentine && (k % 2));
+        }
+        map.build();
+        TEST_ASSERT_EQUAL(size, map.total);
+
+        std::vector<int> hits(count * length, 0);
+        for (int i=0; i<size; i++) {
+          int k = map.which[i];
+          int p = i - k*length;
+          TEST_ASSERT_EQUAL(i / length, k);
+          TEST_ASSERT_EQUAL((serpentine && (k % 2)) ? map.lengths[k]-1-p : p, map.index[i]);
+          TEST_ASSERT_LESS_THAN(map.lengths[k], map.index[i]);
+          hits[k*length + map.index[i]]++;
+        }
+        int total = 0;
+        for (int h : hits) { TEST_ASSERT_LESS_OR_EQUAL(1, h); total += h; }
+        TEST_ASSERT_EQUAL(size, total);
+      }
+}
+
+void test_macro_through_map_is_the_single_strip_frame()
+{
+  for (int count : {2, 3, 4, 8})
+    for (int serpentine=0; serpentine<2; serpentine++)
+    {
+      setupLight(750, count, serpentine);
+      updateMacro(1234 - renderAhead, 0, 1);      // same frame shown (shorter outputs render less ahead)
+      light->update();
+      std::vector<CRGBW> mapped(750);
+      for (int i=0; i<750; i++) mapped[i] = lit(i);
+
+      setupLight(750, 1, false);
+      updateMacro(1234 - renderAhead, 0, 1);
+      light->update();
+      for (int i=0; i<750; i++) TEST_ASSERT_TRUE(mapped[i] == lit(i));
+    }
+}
+
+void test_flash_off_and_clear_cover_every_output()
+{
+  setupLight(750, 4, true);
+  stopMacro();
+  outputs->all(CRGBW{10, 20, 30, 0});
+
+  light->anim("flash")->push(1, 50, 100)->play();
+  light->update();
+  light->anim("flash")->stop();
+  for (int i=0; i<750; i++) TEST_ASSERT_TRUE(lit(i) == CRGBW(CRGBW::White));
+
+  light->anim("off")->push(1)->play();
+  light->update();
+  light->anim("off")->stop();
+  for (int i=0; i<750; i++) TEST_ASSERT_TRUE(lit(i) == CRGBW());
+
+  // WIFI state: clear, first 5 logical pixels lit
+  outputs->all(CRGBW{10, 20, 30, 0});
+  stripClear();
+  for (int i=0; i<5; i++) stripPix(i, CRGBW::Cyan);
+  for (int i=0; i<750; i++) TEST_ASSERT_TRUE(lit(i) == (i < 5 ? CRGBW(CRGBW::Cyan) : CRGBW()));
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_remap_is_one_to_one_in_output_order);
+  RUN_TEST(test_macro_through_map_is_the_single_strip_frame);
+  RUN_TEST(test_flash_off_and_clear_cover_every_output);
+  return UNITY_END();
+}
@@ -0,0 +1,85 @@
+// RENDER AHEAD (light.h)
+//   a node renders the frame for the time its strip lights up (now + wire time of its strip):
+//   nodes with different strip sizes light up the same frame, and auto-next, at the same time.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+
+// Level ramp along the macro time
+class Anim_test_ramp : public Anim_cloud {
+  public:
+    void draw(int data[ANIM_DATA_SLOTS]) {
+      int level = data[1] * 255 / data[0];
+      for (int i=0; i<this->size(); i++) this->pixel(i, CRGBW{level, 0, 0, 0});
+    }
+};
+
+// One node: its strip, from boot
+struct Node {
+  int size;
+  Anim_test_ramp* ramp;
+  Anim_test_ramp* next;
+
+  void setup() {
+    lightSetup(new K32(), size, LED_WS2812B_V3, 27);
+    macroCount = 0;
+    macro = -1;
+    macroPlaying = -1;
+    fadeFrom = -1;
+    addMacro(ramp = new Anim_test_ramp, 1000, 2);
+    addMacro(next = new Anim_test_ramp, 1000);
+    setActiveMacro(0, 0);
+  }
+};
+
+int sizes[] = {25, 750, 3000};
+
+void setUp() {}
+void tearDown() {}
+
+// Time (wall, as seen on the strip) at which the ramp shows time
+uint32_t lightUpAt(Node& node, int time)
+{
+  for (uint32_t now=0; now<1000; now++) {
+    updateMacro(now, 0, 1);
+    if (node.ramp->data[1] >= time) return now + renderAhead;
+  }
+  return 0;
+}
+
+void test_same_frame_lights_up_at_the_same_time()
+{
+  uint32_t reference = 0;
+  for (int size : sizes) {
+    Node node{size};
+    node.setup();
+    uint32_t at = lightUpAt(node, 500);
+    if (!reference) reference = at;
+    TEST_ASSERT_EQUAL_UINT32(reference, at);
+  }
+}
+
+// Auto-next after the 2 loops of the ramp: next macro lit up at the boundary, same offset everywhere
+void test_auto_next_lights_up_at_the_loop_boundary()
+{
+  for (int size : sizes) {
+    Node node{size};
+    node.setup();
+    uint32_t now = 0;
+    for (; now<3000; now++) {
+      updateMacro(now, 0, 1, true);
+      if (macroPlaying == 1) break;
+    }
+    TEST_ASSERT_EQUAL_UINT32(2000, now + renderAhead);
+    TEST_ASSERT_EQUAL_UINT32(2000, macroTimeOffset);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_frame_lights_up_at_the_same_time);
+  RUN_TEST(test_auto_next_lights_up_at_the_loop_boundary);
+  return UNITY_END();
+}
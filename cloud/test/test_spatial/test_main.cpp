@@ -0,0 +1,93 @@
+// SPATIAL MAP (spatial.h)
+//   SP= values: position only keeps the shape, points replace it, malformed ones are refused.
+//   Default map: one row per channel, strips centered on their node, no overlap between
+//   neighbours whatever the strip length. Pixels spread evenly along a polyline shape.
+
+#include <unity.h>
+#include <Preferences.h>
+#include "spatial.h"
+
+void setUp() {
+  Preferences::store().clear();
+}
+void tearDown() {}
+
+void test_parse_position_keeps_shape() {
+  SpatialMap map;
+  map.load(8);
+  TEST_ASSERT_TRUE(map.parse("10,20,30,0,0,0,100,0,0,100,100,0"));
+  TEST_ASSERT_EQUAL(3, map.shape.count);
+  TEST_ASSERT_EQUAL(100, map.shape.points[2][1]);
+
+  TEST_ASSERT_TRUE(map.parse("-50,60,70"));
+  TEST_ASSERT_EQUAL(-50, map.shape.node[0]);
+  TEST_ASSERT_EQUAL(70, map.shape.node[2]);
+  TEST_ASSERT_EQUAL(3, map.shape.count);
+  TEST_ASSERT_EQUAL_STRING("-50,60,70,0,0,0,100,0,0,100,100,0", map.toString().c_str());
+}
+
+void test_parse_refuses_partial_points() {
+  SpatialMap map;
+  map.load(8);
+  TEST_ASSERT_FALSE(map.parse("10,20"));
+  TEST_ASSERT_FALSE(map.parse("10,20,30,1,2"));
+  TEST_ASSERT_EQUAL(0, map.shape.node[0]);
+  TEST_ASSERT_EQUAL(0, map.shape.count);
+}
+
+void test_saved_map_loads_back() {
+  SpatialMap map;
+  map.load(3);
+  map.parse("10,20,30,0,0,0,0,0,200");
+  map.save();
+
+  SpatialMap other;
+  other.load(12);
+  TEST_ASSERT_EQUAL_STRING(map.toString().c_str(), other.toString().c_str());
+}
+
+// Default map, long strips (750 px = 12.5 m): neighbours on separate rows, inside the room
+void test_default_rows_dont_overlap() {
+  SpatialMap a, b;
+  a.load(7);
+  b.load(8);
+  a.build(750);
+  b.build(750);
+  TEST_ASSERT_EQUAL(750, a.size);
+
+  TEST_ASSERT_EQUAL(-SPATIAL_SPACING, a.y[0]);
+  TEST_ASSERT_EQUAL(0, b.y[0]);
+  for (int i=0; i<750; i++) {
+    TEST_ASSERT_EQUAL(a.y[0], a.y[i]);
+    TEST_ASSERT_EQUAL(a.x[i], b.x[i]);
+    TEST_ASSERT_LESS_OR_EQUAL(SPATIAL_ROOM / 2, abs(a.x[i]));
+    if (i) TEST_ASSERT_GREATER_THAN(a.x[i-1], a.x[i]);
+  }
+  TEST_ASSERT_INT_WITHIN(1, 0, a.x[374] + a.x[375]);      // centered on the node
+}
+
+// L shape: 100 cm along x then 100 cm along y, 200 px at pixel centers
+void test_pixels_along_shape() {
+  SpatialMap map;
+  map.load(8);
+  map.parse("300,-400,0,0,0,0,100,0,0,100,100,0");
+  map.build(200);
+
+  for (int i=0; i<200; i++) {
+    float at = i + 0.5f;                                  // cm along the shape
+    TEST_ASSERT_INT_WITHIN(1, 300 + min(at, 100.0f), map.x[i]);
+    TEST_ASSERT_INT_WITHIN(1, -400 + max(at - 100, 0.0f), map.y[i]);
+  }
+  for (int i=0; i<200; i++)
+    TEST_ASSERT_INT_WITHIN(1, (int)sqrtf((float)map.x[i]*map.x[i] + (float)map.y[i]*map.y[i]), map.radius[i]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_position_keeps_shape);
+  RUN_TEST(test_parse_refuses_partial_points);
+  RUN_TEST(test_saved_map_loads_back);
+  RUN_TEST(test_default_rows_dont_overlap);
+  RUN_TEST(test_pixels_along_shape);
+  return UNITY_END();
+}
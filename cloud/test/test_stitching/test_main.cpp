@@ -0,0 +1,89 @@
+// VIRTUAL STRIP (peer.h canvas, anim_cloud.h globalOffset / globalSize)
+//   clouds of different strip sizes learn their slice of the virtual strip from the peers list,
+//   the slices they draw stitch into the frame of one strip as long as all of them.
+
+#include <unity.h>
+#include "anim_cloudled.h"
+#include "peer.h"
+#include <vector>
+
+#define NODES 3
+
+const uint32_t ids[NODES] = {101, 202, 303};
+const int channels[NODES] = {0, 1, 2};
+const int pixels[NODES] = {25, 750, 100};
+const int total = 25 + 750 + 100;
+
+PeersPool* pools[NODES];
+
+void setUp() {}
+void tearDown() {}
+
+// Each node knows the others from their C=<channel>:<pixels> messages,
+// the last one from the master list (CL= round trip)
+void meet()
+{
+  for (int n=0; n<NODES; n++) {
+    pools[n] = new PeersPool(ids[n], channels[n]);
+    pools[n]->ownerPixels(pixels[n]);
+    for (int m=0; m<NODES; m++)
+      if (m != n && n != NODES-1) {
+        String c = String(channels[m]) + ":" + String(pixels[m]);
+        pools[n]->addPeer(ids[m], c.toInt(), PeersPool::parsePixels(c));
+      }
+  }
+  PeersPool remote(pools[0]->toString(), ids[0]);
+  pools[NODES-1]->import(&remote);
+}
+
+void test_slices_follow_channel_order()
+{
+  meet();
+  int offset = 0;
+  for (int n=0; n<NODES; n++) {
+    TEST_ASSERT_EQUAL(offset, pools[n]->canvasOffset());
+    TEST_ASSERT_EQUAL(total, pools[n]->canvasSize());
+    offset += pixels[n];
+  }
+}
+
+void test_slices_stitch_into_the_single_strip_frame()
+{
+  meet();
+  Anim_cloud_flow single, nodes[NODES];
+  std::vector<CRGBW> full(total), part[NODES];
+  for (int n=0; n<NODES; n++) {
+    part[n].resize(pixels[n]);
+    nodes[n].globalOffset = pools[n]->canvasOffset();
+    nodes[n].globalSize = pools[n]->canvasSize();
+  }
+
+  int frame[ANIM_DATA_SLOTS] = {0};
+  int lit = 0;                  // frames lit on some slices only
+  for (int t=0; t<4000; t+=7) {
+    frame[0] = 4000;
+    frame[1] = t;
+    frame[2] = t / 13;
+    frame[3] = 1;
+    frame[5] = NODES;
+
+    frame[4] = 0;
+    single.render(frame, full.data(), total);
+    for (int n=0; n<NODES; n++) {
+      frame[4] = n;
+      nodes[n].render(frame, part[n].data(), pixels[n]);
+      for (int i=0; i<pixels[n]; i++)
+        TEST_ASSERT_TRUE(part[n][i] == full[pools[n]->canvasOffset() + i]);
+    }
+    if (full[0] != full[total-1]) lit++;
+  }
+  TEST_ASSERT_GREATER_THAN(0, lit);
+}
+
+int main(int argc, char** argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_slices_follow_channel_order);
+  RUN_TEST(test_slices_stitch_into_the_single_strip_frame);
+  return UNITY_END();
+}
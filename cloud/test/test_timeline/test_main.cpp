@@ -0,0 +1,196 @@
+// SHOW TIMELINE (timeline.h)
+//   chunks in any order make the timeline, a corrupt one is refused, TP= before the last chunk
+//   arms the start and reports the missing chunks, the show clock runs across the 32-bit
+//   node time wrap (71 min) and across a seek before the wrap.
+//   A cue prepares its macro with the cue seed, even when it repeats the playing macro.
+
+#include <unity.h>
+#include <K32.h>
+#include "light.h"
+#include "anim_cloudled.h"
+#include "timeline.h"
+#include <vector>
+
+#define CUES 40       // 3 chunks
+
+Cue show[CUES];
+
+void setUp() {
+  for (int i=0; i<CUES; i++) show[i] = { (uint32_t)i * 30000, (uint8_t)(i % 20), (uint16_t)(1000 + i), 0 };
+}
+void tearDown() {}
+
+// TL= payloads (after "TL="), as cloud/show builds them
+std::vector<String> chunks() {
+  std::vector<String> list;
+  int n = (CUES + TIMELINE_CHUNK - 1) / TIMELINE_CHUNK;
+  char head[32];
+  snprintf(head, sizeof(head), "%d,%x", CUES, Timeline::hash(show, CUES));
+  for (int k=0; k<n; k++) {
+    String msg = String(k) + "/" + String(n) + "," + head + ":";
+    for (int i=k*TIMELINE_CHUNK; i<CUES && i<(k+1)*TIMELINE_CHUNK; i++) {
+      if (i > k*TIMELINE_CHUNK) msg += ";";
+      msg += String(show[i].at) + "," + String(show[i].macro) + "," + String(show[i].seed) + "," + String(show[i].master);
+    }
+    list.push_back(msg);
+  }
+  return list;
+}
+
+void test_chunks_any_order() {
+  Timeline tl;
+  std::vector<String> list = chunks();
+  TEST_ASSERT_FALSE(tl.chunk(list[2]));
+  TEST_ASSERT_FALSE(tl.chunk(list[0]));
+  TEST_ASSERT_TRUE(tl.chunk(list[1]));
+  TEST_ASSERT_TRUE(tl.ready);
+  TEST_ASSERT_EQUAL(CUES, tl.count);
+  TEST_ASSERT_EQUAL(0, tl.missing());
+  for (int i=0; i<CUES; i++) {
+    TEST_ASSERT_EQUAL(show[i].at, tl.cues[i].at);
+    TEST_ASSERT_EQUAL(show[i].seed, tl.cues[i].seed);
+  }
+}
+
+void test_corrupt_refused() {
+  Timeline tl;
+  std::vector<String> list = chunks();
+  list[1].replace(",1017,", ",1018,");
+  for (String& msg : list) tl.chunk(msg);
+  TEST_ASSERT_FALSE(tl.ready);
+}
+
+void test_play_before_ready_arms() {
+  Timeline tl;
+  std::vector<String> list = chunks();
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, tl.missing());     // nothing seen yet
+
+  tl.chunk(list[0]);
+  tl.chunk(list[2]);
+  TEST_ASSERT_FALSE(tl.play(5000));
+  TEST_ASSERT_FALSE(tl.playing);
+  TEST_ASSERT_TRUE(tl.armed);
+  TEST_ASSERT_EQUAL_HEX32(0x2, tl.missing());
+  TEST_ASSERT_EQUAL_HEX32(Timeline::hash(show, CUES), tl.missingChecksum());
+
+  // Resent chunk => plays, in phase with the armed start
+  TEST_ASSERT_TRUE(tl.chunk(list[1]));
+  TEST_ASSERT_TRUE(tl.playing);
+  TEST_ASSERT_FALSE(tl.armed);
+  TEST_ASSERT_EQUAL(95000, tl.showTime(100000000));
+  TEST_ASSERT_EQUAL(3, tl.cueAt(95000));
+}
+
+void test_stop_disarms() {
+  Timeline tl;
+  std::vector<String> list = chunks();
+  tl.chunk(list[0]);
+  tl.play(5000);
+  tl.stop();
+  tl.chunk(list[1]);
+  tl.chunk(list[2]);
+  TEST_ASSERT_TRUE(tl.ready);
+  TEST_ASSERT_FALSE(tl.playing);
+}
+
+// Show started 10 s before the node time wraps, runs 20 min across it
+void test_show_across_wrap() {
+  Timeline tl;
+  for (String& msg : chunks()) tl.chunk(msg);
+
+  uint32_t nodeUs = 0xFFFFFFFFu - 10000000u;
+  uint32_t start = nodeUs / 1000;
+  TEST_ASSERT_TRUE(tl.play(start));
+
+  int32_t last = -1;
+  for (int step=0; step<=1200; step++) {
+    int32_t time = tl.showTime(nodeUs);
+    TEST_ASSERT_INT_WITHIN(1, step * 1000, time);
+    TEST_ASSERT_EQUAL(min(time / 30000, CUES-1), tl.cueAt(time));
+    TEST_ASSERT_TRUE(time > last);
+    last = time;
+    nodeUs += 1000000;
+  }
+}
+
+// Bridge: start = now + delay - seek, in 32-bit mesh ms (wraps below 0 or beyond 4294967 ms)
+void test_start_modulo_wrap() {
+  Timeline tl;
+  for (String& msg : chunks()) tl.chunk(msg);
+
+  // Seek 10 min, 1 s after the node time wrapped
+  uint32_t now = 1000;
+  tl.play(now + 0 - 600000);
+  TEST_ASSERT_EQUAL(600000, tl.showTime(now * 1000));
+
+  // Start 2 s ahead, beyond the wrap
+  now = 0xFFFFFFFFu / 1000;
+  tl.play(now + 2000);
+  TEST_ASSERT_INT_WITHIN(1, -2000, tl.showTime(now * 1000));
+  TEST_ASSERT_EQUAL(-1, tl.cueAt(tl.showTime(now * 1000)));
+  TEST_ASSERT_INT_WITHIN(1, 1000, tl.showTime(now * 1000 + 3000000));
+  TEST_ASSERT_EQUAL(0, tl.cueAt(tl.showTime(now * 1000 + 3000000)));
+}
+
+// Colors picked in prepare()
+class Anim_test_colors : public Anim_cloud {
+  public:
+    CRGBW color;
+    int prepared = 0;
+
+    void prepare() {
+      color = CRGBW{(int)random(256), (int)random(256), (int)random(256), 0};
+      prepared++;
+    }
+    void draw(int data[ANIM_DATA_SLOTS]) { this->all(color); }
+};
+
+K32* k32;
+Anim_test_colors* colors;
+
+// Cues of the timeline, as main.cpp timelineUpdate() plays them
+void playCue(const Cue& cue, uint32_t now) {
+  cueMacro(now, cue.macro, cue.seed);
+  updateMacro(now, 0, 1);
+  light->update();
+}
+
+// Two cues on the same macro, new seed: prepared again, colors of the new seed
+void test_same_macro_new_seed() {
+  Cue first = { 0, 1, 1000, 0 };
+  Cue second = { 30000, 1, 1001, 0 };
+
+  stopMacro();
+  playCue(first, 0);
+  CRGBW seed1000 = colors->color;
+  int prepared = colors->prepared;
+
+  playCue(second, 30000);
+  TEST_ASSERT_EQUAL(1, macroPlaying);
+  TEST_ASSERT_EQUAL(prepared + 1, colors->prepared);
+  TEST_ASSERT_EQUAL(30000, macroTimeOffset);
+  TEST_ASSERT_FALSE(seed1000.r == colors->color.r && seed1000.g == colors->color.g && seed1000.b == colors->color.b);
+
+  // Same seed again => same colors (as on every other node)
+  playCue(first, 60000);
+  TEST_ASSERT_EQUAL(seed1000.r, colors->color.r);
+  TEST_ASSERT_EQUAL(seed1000.g, colors->color.g);
+  TEST_ASSERT_EQUAL(seed1000.b, colors->color.b);
+}
+
+int main() {
+  k32 = new K32();
+  lightSetup(k32, 60, LED_WS2812B_V3, 27);
+  addMacro(new Anim_cloud_wind, 3000);
+  addMacro(colors = new Anim_test_colors, 1000);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_chunks_any_order);
+  RUN_TEST(test_corrupt_refused);
+  RUN_TEST(test_play_before_ready_arms);
+  RUN_TEST(test_stop_disarms);
+  RUN_TEST(test_show_across_wrap);
+  RUN_TEST(test_start_modulo_wrap);
+  RUN_TEST(test_same_macro_new_seed);
+  return UNITY_END();
+}
@@ -0,0 +1,212 @@
+// TRANSPORT (transport.h) under loss
+//   12 nodes, random latency 1-20 ms (out of order), loss on every message (acks too).
+//   Critical commands are handled once by every node, resent to the missing ones only;
+//   a burst as long as a timeline (chunks + TP=) keeps every message pending until acked;
+//   states are never applied older than the last one of their kind (C=, M=, by zone);
+//   a critical message to more nodes than a pending slot tracks reaches and counts all of them.
+
+#include <unity.h>
+#include "transport.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+#define NODES 12
+
+struct Wire {
+  int from, to;
+  String msg;
+  uint32_t at;
+};
+
+Transport* nodes[NODES];
+std::deque<Wire> air;
+std::map<std::pair<int, std::string>, int> handled;
+int lastState[NODES];
+int staleApplied = 0;
+int current = 0;
+int loss = 0;
+
+void broadcast(String& msg, bool includeSelf) {
+  for (int i=0; i<NODES; i++)
+    if (i != current) air.push_back({current, i, msg, millis() + 1 + (uint32_t)random(20)});
+}
+void single(uint32_t to, String& msg) {
+  if (to < NODES) air.push_back({current, (int)to, msg, millis() + 1 + (uint32_t)random(20)});
+}
+void handle(uint32_t from, String& msg) {
+  if (msg.startsWith("S=")) {
+    int v = msg.substring(2).toInt();
+    if (v < lastState[current]) staleApplied++;
+    lastState[current] = v;
+  }
+  else handled[{current, std::string(msg.c_str())}]++;
+}
+
+void setUp() {
+  hostClock.manual = true;
+  hostClock.us = 0;
+  randomSeed(1);
+  air.clear();
+  handled.clear();
+  staleApplied = 0;
+  for (int i=0; i<NODES; i++) {
+    nodes[i] = new Transport();
+    nodes[i]->broadcast = broadcast;
+    nodes[i]->single = single;
+    nodes[i]->handler = handle;
+    nodes[i]->begin(i);
+    lastState[i] = -1;
+  }
+}
+void tearDown() {
+  for (int i=0; i<NODES; i++) delete nodes[i];
+}
+
+std::list<uint32_t> everyone() {
+  std::list<uint32_t> all;
+  for (int i=0; i<NODES; i++) all.push_back(i);
+  return all;
+}
+
+// One ms: deliver what is due (lost at loss %), then update every node
+void step() {
+  for (size_t k=0; k<air.size(); ) {
+    if (air[k].at > millis()) { k++; continue; }
+    Wire w = air[k];
+    air.erase(air.begin() + k);
+    if (random(100) < loss) continue;
+    current = w.to;
+    nodes[w.to]->receive(w.from, w.msg);
+  }
+  for (int i=0; i<NODES; i++) {
+    current = i;
+    nodes[i]->update();
+  }
+  hostClock.us += 1000;
+}
+
+// Commands not handled / handled more than once by nodes 1..11
+void count(const char* prefix, int commands, int& missing, int& twice) {
+  missing = twice = 0;
+  for (int c=0; c<commands; c++)
+    for (int i=1; i<NODES; i++) {
+      int n = handled[{i, std::string(prefix) + std::to_string(c)}];
+      if (n == 0) missing++;
+      if (n > 1) twice++;
+    }
+}
+
+// 100 commands, one every 500 ms, a state every 7 ms
+void run(int percent, int& missing, int& twice) {
+  loss = percent;
+  int sent = 0;
+  for (int t=0; t<60000; t++) {
+    if (t % 500 == 0 && sent < 100) { current = 0; nodes[0]->sendCritical("CMD" + String(sent++), everyone()); }
+    if (t % 7 == 0) { current = 1; nodes[1]->sendState("S=" + String(t)); }
+    step();
+  }
+  count("CMD", 100, missing, twice);
+}
+
+void test_no_loss() {
+  int missing, twice;
+  run(0, missing, twice);
+  TEST_ASSERT_EQUAL(0, missing);
+  TEST_ASSERT_EQUAL(0, twice);
+  TEST_ASSERT_EQUAL(0, nodes[0]->retries);
+  TEST_ASSERT_EQUAL(nodes[0]->expected, nodes[0]->delivered);
+  TEST_ASSERT_EQUAL(0, staleApplied);
+}
+
+void test_loss_10() {
+  int missing, twice;
+  run(10, missing, twice);
+  TEST_ASSERT_EQUAL(0, missing);
+  TEST_ASSERT_EQUAL(0, twice);
+  TEST_ASSERT_GREATER_THAN(0, nodes[0]->retries);
+  TEST_ASSERT_LESS_THAN(nodes[0]->expected / 2, nodes[0]->retries);      // missing nodes only
+  TEST_ASSERT_EQUAL(0, staleApplied);
+}
+
+void test_loss_30() {
+  int missing, twice;
+  run(30, missing, twice);
+  TEST_ASSERT_LESS_OR_EQUAL(11, missing);                                // 1% (6 tries: 0.3^6 per node)
+  TEST_ASSERT_EQUAL(0, twice);
+  TEST_ASSERT_EQUAL(0, staleApplied);
+}
+
+// Timeline: 8 TL= chunks and TP= in the same ms, all pending until acked
+void test_timeline_burst() {
+  loss = 20;
+  current = 0;
+  for (int c=0; c<9; c++) nodes[0]->sendCritical("TL" + String(c), everyone());
+  for (int t=0; t<5000; t++) step();
+
+  int missing, twice;
+  count("TL", 9, missing, twice);
+  TEST_ASSERT_EQUAL(0, missing);
+  TEST_ASSERT_EQUAL(0, twice);
+  TEST_ASSERT_EQUAL(0, nodes[0]->lost);
+}
+
+// Node 1 sends C= then M=, the mesh delivers them the other way round: both applied
+void test_state_kinds_reordered() {
+  std::vector<std::string> applied;
+  static std::vector<std::string>* log;
+  log = &applied;
+  nodes[0]->handler = [](uint32_t from, String& msg) { log->push_back(msg.c_str()); };
+
+  String c = "~100:C=1:101:1";
+  String m = "~101:M=3,5000";
+  nodes[0]->receive(1, m);
+  nodes[0]->receive(1, c);
+  TEST_ASSERT_EQUAL(2, applied.size());
+  TEST_ASSERT_EQUAL(0, nodes[0]->stale);
+
+  // Older of the same kind: dropped, zone by zone, OFF replaces M=
+  String older = "~99:M=2,4000";
+  String zone = "~98:@2:M=1,3000";
+  String off = "~102:OFF";
+  String late = "~101:L=3,5000";
+  nodes[0]->receive(1, older);
+  nodes[0]->receive(1, zone);
+  nodes[0]->receive(1, off);
+  nodes[0]->receive(1, late);
+  TEST_ASSERT_EQUAL(4, applied.size());
+  TEST_ASSERT_EQUAL_STRING("@2:M=1,3000", applied[2].c_str());
+  TEST_ASSERT_EQUAL_STRING("OFF", applied[3].c_str());
+  TEST_ASSERT_EQUAL(2, nodes[0]->stale);
+}
+
+// 30 silent nodes listed before the 11 others (more than TRANSPORT_NODES): all tracked
+void test_beyond_slot_nodes() {
+  std::list<uint32_t> list;
+  for (int i=0; i<30; i++) list.push_back(100 + i);
+  for (int i=1; i<NODES; i++) list.push_back(i);
+
+  loss = 20;
+  current = 0;
+  nodes[0]->sendCritical("BIG0", list);
+  for (int t=0; t<5000; t++) step();
+
+  int missing, twice;
+  count("BIG", 1, missing, twice);
+  TEST_ASSERT_EQUAL(0, missing);
+  TEST_ASSERT_EQUAL(0, twice);
+  TEST_ASSERT_EQUAL(41, nodes[0]->expected);
+  TEST_ASSERT_EQUAL(11, nodes[0]->delivered);
+  TEST_ASSERT_EQUAL(30, nodes[0]->lost);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_loss);
+  RUN_TEST(test_loss_10);
+  RUN_TEST(test_loss_30);
+  RUN_TEST(test_timeline_burst);
+  RUN_TEST(test_state_kinds_reordered);
+  RUN_TEST(test_beyond_slot_nodes);
+  return UNITY_END();
+}
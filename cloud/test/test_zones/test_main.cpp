@@ -0,0 +1,92 @@
+// ZONES (peer.h)
+//   12 nodes on channels 0-11 in 3 zones: A = nodes 0-3 (group 0), B = 4-7 (group 1),
+//   C = 8-11 (group 2), node 5 in B and C. Each node knows the others from the master CL= list.
+//   In each zone: positions 0..n-1, one count, contiguous canvas, one zone master;
+//   node 5 is placed in B, its primary zone (lowest group), and not counted in C.
+
+#include <unity.h>
+#include "peer.h"
+#include <vector>
+
+#define NODES 12
+
+std::vector<PeersPool*> pools;
+uint32_t groups[NODES];
+
+void setUp() {
+  for (int i=0; i<NODES; i++) groups[i] = i < 4 ? 0x1 : i < 8 ? 0x2 : 0x4;
+  groups[5] = 0x6;
+
+  for (int i=0; i<NODES; i++) {
+    pools.push_back(new PeersPool(1000+i, i));
+    pools[i]->ownerPixels(100+i);
+    pools[i]->ownerGroups(groups[i]);
+  }
+
+  // Master builds the list from the C= infos, everyone imports it
+  for (int i=1; i<NODES; i++) {
+    String info = String(i) + ":" + String(100+i) + ":" + String(groups[i], HEX);
+    pools[0]->addPeer(1000+i, i, PeersPool::parsePixels(info), PeersPool::parseGroups(info));
+  }
+  String list = pools[0]->toString();
+  for (int i=1; i<NODES; i++) {
+    PeersPool remote(list, 1000);
+    pools[i]->import(&remote);
+  }
+}
+
+void tearDown() {
+  for (PeersPool* p : pools) delete p;
+  pools.clear();
+}
+
+void test_primary_group() {
+  TEST_ASSERT_EQUAL_HEX32(0x1, PeersPool::primary(0x1));
+  TEST_ASSERT_EQUAL_HEX32(0x2, PeersPool::primary(0x6));
+  TEST_ASSERT_EQUAL_HEX32(0x10, PeersPool::primary(0xF0));
+  TEST_ASSERT_EQUAL_HEX32(0x1, PeersPool::primary(GROUPS_ALL));
+}
+
+void test_whole_mesh() {
+  for (int i=0; i<NODES; i++) {
+    TEST_ASSERT_EQUAL(i, pools[i]->position());
+    TEST_ASSERT_EQUAL(NODES, pools[i]->count());
+    TEST_ASSERT_EQUAL(i == 0, pools[i]->isZoneMaster());
+  }
+}
+
+// Members of each zone, in channel order
+void checkZone(uint32_t zone, std::vector<int> members) {
+  int offset = 0;
+  for (int i : members) pools[i]->zone(zone);
+  for (size_t k=0; k<members.size(); k++) {
+    PeersPool* p = pools[members[k]];
+    TEST_ASSERT_EQUAL(k, p->position());
+    TEST_ASSERT_EQUAL(members.size(), p->count());
+    TEST_ASSERT_EQUAL(offset, p->canvasOffset());
+    TEST_ASSERT_EQUAL(k == 0, p->isZoneMaster());
+    TEST_ASSERT_EQUAL(1000 + members[0], k == 0 ? 1000 + members[0] : p->masterID());
+    offset += p->ownerPixels();
+  }
+  for (int i : members) TEST_ASSERT_EQUAL(offset, pools[i]->canvasSize());
+}
+
+void test_zones() {
+  checkZone(0x1, {0, 1, 2, 3});
+  checkZone(0x2, {4, 5, 6, 7});
+  checkZone(0x4, {8, 9, 10, 11});     // node 5 plays B, not counted in C
+}
+
+// A zone of two groups places node 5 once
+void test_zone_of_groups() {
+  checkZone(0x6, {4, 5, 6, 7, 8, 9, 10, 11});
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_primary_group);
+  RUN_TEST(test_whole_mesh);
+  RUN_TEST(test_zones);
+  RUN_TEST(test_zone_of_groups);
+  return UNITY_END();
+}